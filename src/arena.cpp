@@ -0,0 +1,61 @@
+/****************************************************************************
+  FileName  [ arena.cpp ]
+  Synopsis  [ Implementation of the monotonic arena. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.30 ]
+****************************************************************************/
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#include "arena.h"
+using namespace std;
+
+Arena::Arena(size_t blockSize) :
+    _cur(0), _base(0), _pos(0), _blockEnd(0), _nextSize(blockSize), _allocSize(0),
+    _allocNum(0), _peakSize(0), _capacity(0), _systemAllocNum(0)
+{
+}
+
+Arena::~Arena()
+{
+    for (size_t i = 0, end = _block.size(); i < end; ++i) {
+        free(_block[i]);
+    }
+}
+
+// Rewind to the first block. The blocks are kept.
+void Arena::release()
+{
+    _peakSize = max(_peakSize, _allocSize);
+    _allocSize = 0;
+    _allocNum = 0;
+    _cur = 0;
+    _pos = 0;
+    _base = (_block.empty())? 0: _block[0];
+    _blockEnd = (_block.empty())? 0: _blockSize[0];
+    return;
+}
+
+// The block in use is full: move on to the next kept block that holds the
+// request, or add a block at least twice the size of the last one.
+void* Arena::allocateSlow(size_t size, size_t align)
+{
+    size_t need = size + align;
+    size_t next = (_block.empty())? 0: _cur + 1;
+    while (next < _block.size() && _blockSize[next] < need) ++next;
+    if (next == _block.size()) {
+        size_t blockSize = max(_nextSize, need);
+        char* block = (char*)malloc(blockSize);
+        assert(block != 0);
+        _block.push_back(block);
+        _blockSize.push_back(blockSize);
+        _capacity += blockSize;
+        _nextSize = 2 * blockSize;
+        ++_systemAllocNum;
+    }
+    _cur = next;
+    _base = _block[next];
+    _pos = 0;
+    _blockEnd = _blockSize[next];
+    return this->allocate(size, align);
+}
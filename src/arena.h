@@ -0,0 +1,105 @@
+/****************************************************************************
+  FileName  [ arena.h ]
+  Synopsis  [ Define the monotonic arena for the scratch memory of a net. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.30 ]
+****************************************************************************/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+// Monotonic memory for the scratch of one net. Memory is handed out by
+// bumping a pointer through large blocks and is never given back piece by
+// piece; release() rewinds to the first block in O(1) and keeps all blocks
+// for the next net. Blocks grow geometrically, so a router that sees the
+// same kind of nets stops calling malloc after the first ones. An arena
+// is not thread-safe: parallel tasks use one arena each.
+class Arena
+{
+public:
+    // constructor and destructor
+    Arena(size_t blockSize = 1 << 16);
+    ~Arena();
+
+    // memory methods
+    void* allocate(size_t size, size_t align) {
+        size_t pos = (_pos + align - 1) & ~(align - 1);
+        if (pos + size > _blockEnd) return this->allocateSlow(size, align);
+        _pos = pos + size;
+        _allocSize += size;
+        ++_allocNum;
+        return _base + pos;
+    }
+    void release();
+
+    // statistics
+    size_t getAllocSize() const     { return _allocSize; }
+    size_t getAllocNum() const      { return _allocNum; }
+    size_t getPeakSize() const      { return max(_peakSize, _allocSize); }
+    size_t getCapacity() const      { return _capacity; }
+    size_t getBlockNum() const      { return _block.size(); }
+    size_t getSystemAllocNum() const    { return _systemAllocNum; }
+
+private:
+    vector<char*>   _block;         // blocks in the order they are used
+    vector<size_t>  _blockSize;     // size of each block
+    size_t          _cur;           // block in use
+    char*           _base;          // start of the block in use
+    size_t          _pos;           // next free byte in the block in use
+    size_t          _blockEnd;      // size of the block in use, 0 if none
+    size_t          _nextSize;      // size of the next new block
+    size_t          _allocSize;     // bytes handed out since release()
+    size_t          _allocNum;      // allocations since release()
+    size_t          _peakSize;      // largest _allocSize of the former nets
+    size_t          _capacity;      // bytes in all blocks
+    size_t          _systemAllocNum;    // blocks taken from the system
+
+    // private member functions
+    void* allocateSlow(size_t size, size_t align);
+
+    // non-copyable
+    Arena(const Arena&);
+    Arena& operator = (const Arena&);
+};
+
+// STL allocator drawing from an arena; deallocate() does nothing.
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    ArenaAllocator(Arena* arena) : _arena(arena) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other._arena) {}
+
+    T* allocate(size_t n) {
+        return (T*)_arena->allocate(n * sizeof(T), alignof(T));
+    }
+    void deallocate(T*, size_t) {}
+
+    // data members
+    Arena*      _arena;     // arena of the memory
+};
+
+template <class T, class U>
+bool operator == (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return (a._arena == b._arena);
+}
+
+template <class T, class U>
+bool operator != (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return (a._arena != b._arena);
+}
+
+// vector whose storage is scratch of a net
+template <class T>
+using ArenaVector = vector<T, ArenaAllocator<T> >;
+
+#endif // ARENA_H
@@ -0,0 +1,141 @@
+/****************************************************************************
+  FileName  [ batchRouter.cpp ]
+  Synopsis  [ Implementation of the multi-net batch router. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.20 ]
+****************************************************************************/
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include "batchRouter.h"
+#include "parser.h"
+#include "netRouter.h"
+using namespace std;
+
+BatchRouter::BatchRouter(size_t threadNum, const RouterOption& option) :
+    _option(option), _threadNum(threadNum), _time(0)
+{
+    if (_threadNum == 0) {
+        _threadNum = thread::hardware_concurrency();
+    }
+    if (_threadNum == 0) {
+        _threadNum = 1;
+    }
+}
+
+// Batch format:
+//   NumNets = <n>
+//   Net <name>
+//   Boundary = (x,y), (x,y)
+//   NumPins = <m>
+//   PIN <name> (x,y)
+//   ...
+// Each "Net" line starts a block in the single-net format. The blocks are
+// only located here; each worker parses its own nets in place.
+void BatchRouter::parseInput(const char* begin, const char* end)
+{
+    Scanner scanner(begin, end);
+    bool ok = scanner.match("NumNets") && scanner.match("=");
+    assert(ok);
+    size_t netNum = scanner.getInt();
+
+    _netName.clear();
+    _netBegin.clear();
+    _netEnd.clear();
+    _netName.reserve(netNum);
+    _netBegin.reserve(netNum);
+    _netEnd.reserve(netNum);
+
+    while (!scanner.eof()) {
+        ok = scanner.match("Net");
+        assert(ok);
+        _netName.push_back(scanner.getToken());
+        _netBegin.push_back(scanner.getPos());
+        const char* next = scanner.findLine("Net");
+        _netEnd.push_back(next);
+        scanner = Scanner(next, end);
+    }
+    assert(_netName.size() == netNum);
+    (void)ok;
+    return;
+}
+
+void BatchRouter::route()
+{
+    size_t netNum = _netName.size();
+    _result.assign(netNum, string());
+    _wireLength.assign(netNum, 0);
+    _pinNum.assign(netNum, 0);
+
+    auto start = chrono::steady_clock::now();
+    atomic<size_t> next(0);
+    size_t threadNum = min(_threadNum, max(netNum, (size_t)1));
+    vector<thread> workers;
+    for (size_t i = 1; i < threadNum; ++i) {
+        workers.push_back(thread(&BatchRouter::routeWorker, this, ref(next)));
+    }
+    this->routeWorker(next);
+    for (size_t i = 0, end = workers.size(); i < end; ++i) {
+        workers[i].join();
+    }
+    auto stop = chrono::steady_clock::now();
+    _time = chrono::duration<double>(stop - start).count();
+
+    return;
+}
+
+// each worker owns one router per coordinate width and pulls nets until
+// none is left
+void BatchRouter::routeWorker(atomic<size_t>& next)
+{
+    NetRouter netRouter(_option);
+    Writer writer;
+    for (size_t i = next++; i < _netName.size(); i = next++) {
+        RouterBase* router = netRouter.getRouter(getCoordWidth(_netBegin[i], _netEnd[i]));
+        router->parseInput(_netBegin[i], _netEnd[i]);
+        router->route();
+        writer.clear();
+        router->writeResult(writer);
+        _result[i].assign(writer.data(), writer.size());
+        _wireLength[i] = router->getWireLength();
+        _pinNum[i] = router->getOPinNum();
+    }
+    return;
+}
+
+// reporting functions
+void BatchRouter::printSummary() const
+{
+    long wireLength = 0;
+    size_t pinNum = 0;
+    for (size_t i = 0, end = _netName.size(); i < end; ++i) {
+        wireLength += _wireLength[i];
+        pinNum += _pinNum[i];
+    }
+
+    cout << "=======================================================" << endl;
+    cout << "NumRoutedNets = " << _netName.size() << endl;
+    cout << "NumRoutedPins = " << pinNum << endl;
+    cout << "WireLength = " << wireLength << endl;
+    cout << "Threads = " << _threadNum << endl;
+    cout << "Time = " << _time << " secs " << endl;
+    cout << "=======================================================" << endl;
+    return;
+}
+
+void BatchRouter::writeResult(ostream& outFile) const
+{
+    Writer writer(outFile);
+    writer.put("NumNets = ");
+    writer.putInt(_netName.size());
+    writer.put('\n');
+    for (size_t i = 0, end = _netName.size(); i < end; ++i) {
+        writer.put("Net ");
+        writer.put(_netName[i]._str, _netName[i]._len);
+        writer.put('\n');
+        writer.put(_result[i].data(), _result[i].size());
+    }
+    writer.flush();
+    outFile.flush();
+    return;
+}
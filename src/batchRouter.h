@@ -0,0 +1,51 @@
+/****************************************************************************
+  FileName  [ batchRouter.h ]
+  Synopsis  [ Define the interface of the multi-net batch router. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.20 ]
+****************************************************************************/
+#ifndef BATCHROUTER_H
+#define BATCHROUTER_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <atomic>
+#include "router.h"
+using namespace std;
+
+class BatchRouter
+{
+public:
+    // constructor and destructor
+    BatchRouter(size_t threadNum = 0, const RouterOption& option = RouterOption());
+    ~BatchRouter() {}
+
+    // basic access methods
+    size_t getNetNum() const    { return _netName.size(); }
+    size_t getThreadNum() const { return _threadNum; }
+
+    // modify methods
+    void parseInput(const char* begin, const char* end);
+    void route();
+
+    // reporting functions
+    void printSummary() const;
+    void writeResult(ostream& outFile) const;
+
+private:
+    RouterOption    _option;        // options of each net router
+    size_t          _threadNum;     // number of worker threads
+    double          _time;          // wall-clock routing time
+    vector<StrView> _netName;       // name of each net
+    vector<const char*> _netBegin;  // start of each net block in the input
+    vector<const char*> _netEnd;    // end of each net block in the input
+    vector<string>  _result;        // routed result of each net
+    vector<long>    _wireLength;    // wirelength of each net
+    vector<size_t>  _pinNum;        // number of routed pins of each net
+
+    // private member functions
+    void routeWorker(atomic<size_t>& next);
+};
+
+#endif // BATCHROUTER_H
@@ -0,0 +1,363 @@
+/****************************************************************************
+  FileName  [ compact.cpp ]
+  Synopsis  [ Implementation of the segment compaction. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.27 ]
+****************************************************************************/
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+#include <type_traits>
+#include "compact.h"
+#include "radixSort.h"
+using namespace std;
+
+// line runs
+template <class Coord>
+void LineRuns<Coord>::build(vector<Segment<Coord> >& segList)
+{
+    sort(segList.begin(), segList.end(), [](const Segment<Coord>& a, const Segment<Coord>& b) {
+        return (a._line < b._line || (a._line == b._line && a._lo < b._lo));
+    });
+
+    _run.clear();
+    for (size_t i = 0, end = segList.size(); i < end; ++i) {
+        const Segment<Coord>& seg = segList[i];
+        if (!_run.empty() && _run.back()._line == seg._line && seg._lo <= _run.back()._hi) {
+            _run.back()._hi = max(_run.back()._hi, seg._hi);
+        }
+        else {
+            _run.push_back(seg);
+        }
+    }
+
+    _prefix.resize(_run.size() + 1);
+    _prefix[0] = 0;
+    for (size_t i = 0, end = _run.size(); i < end; ++i) {
+        _prefix[i + 1] = _prefix[i] + (_run[i]._hi - _run[i]._lo);
+    }
+    return;
+}
+
+// length of [lo, hi] on the line covered by the runs
+template <class Coord>
+Coord LineRuns<Coord>::getOverlap(Coord line, Coord lo, Coord hi) const
+{
+    size_t first = this->lowerBound(line, lo);
+    auto it = upper_bound(_run.begin() + first, _run.end(), Segment<Coord>(line, hi, hi),
+                          [](const Segment<Coord>& key, const Segment<Coord>& run) {
+        return (key._line < run._line || (key._line == run._line && key._lo < run._lo));
+    });
+    size_t last = it - _run.begin();
+    if (first == last) return 0;
+
+    long length = _prefix[last] - _prefix[first];
+    length -= max((long)lo - (long)_run[first]._lo, 0L);
+    length -= max((long)_run[last - 1]._hi - (long)hi, 0L);
+    return (Coord)length;
+}
+
+// run holding the point at pos on the line, or NONE
+template <class Coord>
+size_t LineRuns<Coord>::findRun(Coord line, Coord pos) const
+{
+    size_t i = this->lowerBound(line, pos);
+    if (i < _run.size() && _run[i]._line == line && _run[i]._lo <= pos) {
+        return i;
+    }
+    return NONE;
+}
+
+// first run at or after (line, pos) that does not end before pos
+template <class Coord>
+size_t LineRuns<Coord>::lowerBound(Coord line, Coord pos) const
+{
+    auto it = lower_bound(_run.begin(), _run.end(), Segment<Coord>(line, pos, pos),
+                          [](const Segment<Coord>& run, const Segment<Coord>& key) {
+        return (run._line < key._line || (run._line == key._line && run._hi < key._lo));
+    });
+    return (it - _run.begin());
+}
+
+// segment compactor
+template <class Coord>
+void SegmentCompactor<Coord>::compact(vector<Pin<Coord> >& pinList, size_t oPinNum, vector<Edge<Coord> >& treeList)
+{
+    typedef typename make_unsigned<Coord>::type UCoord;
+    static const Index NO_PIN = (Index)-1;
+
+    // runs on rows and columns
+    _seg.clear();
+    for (size_t i = 0, end = treeList.size(); i < end; ++i) {
+        const Pin<Coord>& s = pinList[treeList[i]._s];
+        const Pin<Coord>& t = pinList[treeList[i]._t];
+        assert(s._x == t._x || s._y == t._y);
+        if (s._y == t._y && s._x != t._x) {
+            _seg.push_back(Segment<Coord>(s._y, min(s._x, t._x), max(s._x, t._x)));
+        }
+    }
+    _hRun.build(_seg);
+    _seg.clear();
+    for (size_t i = 0, end = treeList.size(); i < end; ++i) {
+        const Pin<Coord>& s = pinList[treeList[i]._s];
+        const Pin<Coord>& t = pinList[treeList[i]._t];
+        if (s._x == t._x && s._y != t._y) {
+            _seg.push_back(Segment<Coord>(s._x, min(s._y, t._y), max(s._y, t._y)));
+        }
+    }
+    _vRun.build(_seg);
+    size_t hNum = _hRun.size();
+    size_t vNum = _vRun.size();
+
+    // nodes: run ends, pins and crossings
+    _node.clear();
+    for (size_t i = 0; i < hNum; ++i) {
+        _node.push_back(make_pair((Index)i, _hRun[i]._lo));
+        _node.push_back(make_pair((Index)i, _hRun[i]._hi));
+    }
+    for (size_t i = 0; i < vNum; ++i) {
+        _node.push_back(make_pair((Index)(hNum + i), _vRun[i]._lo));
+        _node.push_back(make_pair((Index)(hNum + i), _vRun[i]._hi));
+    }
+    for (size_t i = 0; i < oPinNum; ++i) {
+        size_t h = _hRun.findRun(pinList[i]._y, pinList[i]._x);
+        size_t v = _vRun.findRun(pinList[i]._x, pinList[i]._y);
+        if (h != LineRuns<Coord>::NONE) _node.push_back(make_pair((Index)h, pinList[i]._x));
+        if (v != LineRuns<Coord>::NONE) _node.push_back(make_pair((Index)(hNum + v), pinList[i]._y));
+    }
+    this->intersect();
+    sort(_node.begin(), _node.end());
+    _node.erase(unique(_node.begin(), _node.end()), _node.end());
+
+    _point.resize(_node.size());
+    for (size_t i = 0, end = _node.size(); i < end; ++i) {
+        size_t r = _node[i].first;
+        _point[i] = (r < hNum)? Pin<Coord>(_node[i].second, _hRun[r]._line):
+                                Pin<Coord>(_vRun[r - hNum]._line, _node[i].second);
+    }
+    sort(_point.begin(), _point.end(), [](const Pin<Coord>& a, const Pin<Coord>& b) {
+        return (a._x < b._x || (a._x == b._x && a._y < b._y));
+    });
+    _point.erase(unique(_point.begin(), _point.end(), [](const Pin<Coord>& a, const Pin<Coord>& b) {
+        return (a._x == b._x && a._y == b._y);
+    }), _point.end());
+    size_t pointNum = _point.size();
+
+    // pieces between adjacent nodes of a run, in run order
+    _piece.clear();
+    _pieceRun.clear();
+    for (size_t i = 1, end = _node.size(); i < end; ++i) {
+        if (_node[i].first != _node[i - 1].first) continue;
+        size_t r = _node[i].first;
+        size_t s, t;
+        if (r < hNum) {
+            s = this->findPoint(_node[i - 1].second, _hRun[r]._line);
+            t = this->findPoint(_node[i].second, _hRun[r]._line);
+        }
+        else {
+            s = this->findPoint(_vRun[r - hNum]._line, _node[i - 1].second);
+            t = this->findPoint(_vRun[r - hNum]._line, _node[i].second);
+        }
+        _piece.push_back(Edge<Coord>(s, t, _node[i].second - _node[i - 1].second));
+        _pieceRun.push_back(r);
+    }
+    size_t pieceNum = _piece.size();
+
+    // spanning tree of the pieces, shortest first
+    vector<Index> order(pieceNum);
+    iota(order.begin(), order.end(), 0);
+    radixSort(order, [&](Index i) {
+        return (UCoord)_piece[i]._cost;
+    }, 1);
+    vector<Index> par(pointNum);
+    iota(par.begin(), par.end(), 0);
+    auto findRoot = [&](size_t x) {
+        while (par[x] != x) {
+            par[x] = par[par[x]];
+            x = par[x];
+        }
+        return x;
+    };
+    _keep.assign(pieceNum, 0);
+    vector<Index> degree(pointNum, 0);
+    for (size_t i = 0; i < pieceNum; ++i) {
+        const Edge<Coord>& piece = _piece[order[i]];
+        size_t x = findRoot(piece._s);
+        size_t y = findRoot(piece._t);
+        if (x != y) {
+            par[x] = y;
+            _keep[order[i]] = 1;
+            degree[piece._s] += 1;
+            degree[piece._t] += 1;
+        }
+    }
+
+    // pins on the nodes; the first of coincident pins takes the node
+    vector<Index> pinId(pointNum, NO_PIN);
+    for (size_t i = 0; i < oPinNum; ++i) {
+        size_t p = this->findPoint(pinList[i]._x, pinList[i]._y);
+        if (p != pointNum && pinId[p] == NO_PIN) pinId[p] = i;
+    }
+
+    // prune pieces dangling at a node without a pin
+    vector<Index> start(pointNum + 1, 0);
+    for (size_t i = 0; i < pieceNum; ++i) {
+        if (!_keep[i]) continue;
+        start[_piece[i]._s + 1] += 1;
+        start[_piece[i]._t + 1] += 1;
+    }
+    partial_sum(start.begin(), start.end(), start.begin());
+    vector<Index> incident(start[pointNum]);
+    vector<Index> next(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < pieceNum; ++i) {
+        if (!_keep[i]) continue;
+        incident[next[_piece[i]._s]++] = i;
+        incident[next[_piece[i]._t]++] = i;
+    }
+    vector<Index> leaf;
+    for (size_t p = 0; p < pointNum; ++p) {
+        if (degree[p] == 1 && pinId[p] == NO_PIN) leaf.push_back(p);
+    }
+    while (!leaf.empty()) {
+        size_t p = leaf.back();
+        leaf.pop_back();
+        for (size_t j = start[p]; j < start[p + 1]; ++j) {
+            size_t i = incident[j];
+            if (!_keep[i]) continue;
+            _keep[i] = 0;
+            size_t q = (_piece[i]._s == p)? _piece[i]._t: _piece[i]._s;
+            degree[p] -= 1;
+            degree[q] -= 1;
+            if (degree[q] == 1 && pinId[q] == NO_PIN) leaf.push_back(q);
+        }
+    }
+
+    // join kept pieces that continue each other along a run
+    pinList.resize(oPinNum);
+    treeList.clear();
+    auto getPin = [&](size_t p) {
+        if (pinId[p] == NO_PIN) {
+            pinId[p] = pinList.size();
+            pinList.push_back(_point[p]);
+        }
+        return pinId[p];
+    };
+    for (size_t i = 0; i < pieceNum; ++i) {
+        if (!_keep[i]) continue;
+        size_t s = _piece[i]._s;
+        size_t t = _piece[i]._t;
+        Coord cost = _piece[i]._cost;
+        while (i + 1 < pieceNum && _keep[i + 1] && _pieceRun[i + 1] == _pieceRun[i] &&
+               _piece[i + 1]._s == t) {
+            ++i;
+            t = _piece[i]._t;
+            cost += _piece[i]._cost;
+        }
+        size_t sPin = getPin(s);
+        size_t tPin = getPin(t);
+        treeList.push_back(Edge<Coord>(sPin, tPin, cost));
+    }
+    return;
+}
+
+// Every H-run meeting a V-run, by a sweep over x. The active H-runs are
+// kept in a Fenwick tree over the rows (at most one run per row is active,
+// since the runs of a row neither overlap nor touch), and each V-run lists
+// the active rows within its span. Runs that only touch count as meeting.
+template <class Coord>
+void SegmentCompactor<Coord>::intersect()
+{
+    size_t hNum = _hRun.size();
+    size_t vNum = _vRun.size();
+    if (hNum == 0 || vNum == 0) return;
+
+    // rows of the H-runs; runs are sorted by row, so rowNum <= hNum
+    vector<Index> runRow(hNum);
+    size_t rowNum = 0;
+    for (size_t i = 0; i < hNum; ++i) {
+        if (i == 0 || _hRun[i]._line != _hRun[i - 1]._line) ++rowNum;
+        runRow[i] = rowNum - 1;
+    }
+    vector<Coord> row(rowNum);
+    for (size_t i = 0; i < hNum; ++i) row[runRow[i]] = _hRun[i]._line;
+
+    // events: 0 inserts an H-run, 1 lists for a V-run, 2 removes an H-run
+    vector<pair<pair<Coord, uint8_t>, Index> > event;
+    event.reserve(2 * hNum + vNum);
+    for (size_t i = 0; i < hNum; ++i) {
+        event.push_back(make_pair(make_pair(_hRun[i]._lo, (uint8_t)0), (Index)i));
+        event.push_back(make_pair(make_pair(_hRun[i]._hi, (uint8_t)2), (Index)i));
+    }
+    for (size_t i = 0; i < vNum; ++i) {
+        event.push_back(make_pair(make_pair(_vRun[i]._line, (uint8_t)1), (Index)i));
+    }
+    sort(event.begin(), event.end());
+
+    vector<Index> count(rowNum + 1, 0);     // fenwick tree of active rows
+    vector<Index> active(rowNum);           // active H-run of each row
+    size_t logNum = 1;
+    while ((logNum << 1) <= rowNum) logNum <<= 1;
+    auto update = [&](size_t r, int d) {
+        for (size_t k = r + 1; k <= rowNum; k += k & (~k + 1)) count[k] += d;
+    };
+    auto prefix = [&](size_t r) {
+        size_t sum = 0;
+        for (size_t k = r; k > 0; k -= k & (~k + 1)) sum += count[k];
+        return sum;
+    };
+    auto findKth = [&](size_t k) {      // row of the k-th active row, from 1
+        size_t pos = 0;
+        for (size_t step = logNum; step > 0; step >>= 1) {
+            if (pos + step <= rowNum && count[pos + step] < k) {
+                pos += step;
+                k -= count[pos];
+            }
+        }
+        return pos;
+    };
+
+    for (size_t e = 0, end = event.size(); e < end; ++e) {
+        uint8_t type = event[e].first.second;
+        size_t i = event[e].second;
+        if (type == 0) {
+            active[runRow[i]] = i;
+            update(runRow[i], 1);
+        }
+        else if (type == 2) {
+            update(runRow[i], -1);
+        }
+        else {
+            const Segment<Coord>& run = _vRun[i];
+            size_t lo = lower_bound(row.begin(), row.end(), run._lo) - row.begin();
+            size_t hi = upper_bound(row.begin(), row.end(), run._hi) - row.begin();
+            for (size_t k = prefix(lo) + 1, kEnd = prefix(hi); k <= kEnd; ++k) {
+                size_t r = findKth(k);
+                _node.push_back(make_pair(active[r], run._line));
+                _node.push_back(make_pair((Index)(hNum + i), row[r]));
+            }
+        }
+    }
+    return;
+}
+
+// node at (x, y), or the number of nodes if there is none
+template <class Coord>
+size_t SegmentCompactor<Coord>::findPoint(Coord x, Coord y) const
+{
+    auto it = lower_bound(_point.begin(), _point.end(), Pin<Coord>(x, y),
+                          [](const Pin<Coord>& a, const Pin<Coord>& b) {
+        return (a._x < b._x || (a._x == b._x && a._y < b._y));
+    });
+    if (it != _point.end() && it->_x == x && it->_y == y) {
+        return (it - _point.begin());
+    }
+    return _point.size();
+}
+
+// coordinate widths picked by getCoordWidth()
+template class LineRuns<int16_t>;
+template class LineRuns<int32_t>;
+template class LineRuns<int64_t>;
+template class SegmentCompactor<int16_t>;
+template class SegmentCompactor<int32_t>;
+template class SegmentCompactor<int64_t>;
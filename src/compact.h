@@ -0,0 +1,95 @@
+/****************************************************************************
+  FileName  [ compact.h ]
+  Synopsis  [ Define the segment compaction of the rectilinear tree. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.27 ]
+****************************************************************************/
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <vector>
+#include "module.h"
+using namespace std;
+
+// A straight wire on one line, a row (_line = y) for an H-line or a column
+// (_line = x) for a V-line, covering [_lo, _hi] along it.
+template <class Coord>
+class Segment
+{
+public:
+    Segment() {}
+    Segment(Coord line, Coord lo, Coord hi) :
+        _line(line), _lo(lo), _hi(hi) {}
+    ~Segment() {}
+
+    // data members
+    Coord       _line;      // y of a row, x of a column
+    Coord       _lo;        // lower end along the line
+    Coord       _hi;        // upper end along the line
+};
+
+// The union of a set of segments as disjoint runs: segments on the same
+// line that overlap or touch are joined. Runs are sorted by (line, lo).
+template <class Coord>
+class LineRuns
+{
+public:
+    // constructor and destructor
+    LineRuns() {}
+    ~LineRuns() {}
+
+    // basic access methods
+    size_t size() const     { return _run.size(); }
+    const Segment<Coord>& operator [] (size_t i) const { return _run[i]; }
+
+    // modify methods
+    void build(vector<Segment<Coord> >& segList);
+
+    // query methods
+    Coord getOverlap(Coord line, Coord lo, Coord hi) const;
+    size_t findRun(Coord line, Coord pos) const;
+
+    static const size_t NONE = (size_t)-1;
+
+private:
+    vector<Segment<Coord> > _run;       // disjoint runs
+    vector<long>            _prefix;    // total length of the runs before
+
+    // private member functions
+    size_t lowerBound(Coord line, Coord pos) const;
+};
+
+// Post-pass over a rectilinear tree. The H-lines and V-lines are joined into
+// runs per row and column, so overlapping wires are counted once. The runs
+// are cut at their ends, at the pins and wherever an H-run meets a V-run.
+// A spanning tree of these pieces (shortest first) breaks the geometric
+// cycles, pieces dangling at a non-pin end are pruned, and the remaining
+// pieces are joined back into maximal segments. Original pins keep their
+// ids; all other pins are rebuilt. Scratch arrays are kept between calls.
+template <class Coord>
+class SegmentCompactor
+{
+public:
+    // constructor and destructor
+    SegmentCompactor() {}
+    ~SegmentCompactor() {}
+
+    // modify methods
+    void compact(vector<Pin<Coord> >& pinList, size_t oPinNum, vector<Edge<Coord> >& treeList);
+
+private:
+    LineRuns<Coord>             _hRun;      // runs on rows
+    LineRuns<Coord>             _vRun;      // runs on columns
+    vector<Segment<Coord> >     _seg;       // segments of one direction
+    vector<pair<Index, Coord> > _node;      // (run, position) of every node
+    vector<Pin<Coord> >         _point;     // sorted distinct nodes
+    vector<Edge<Coord> >        _piece;     // wire between adjacent nodes
+    vector<Index>               _pieceRun;  // run of each piece
+    vector<uint8_t>             _keep;      // piece kept in the tree
+
+    // private member functions
+    void intersect();
+    size_t findPoint(Coord x, Coord y) const;
+};
+
+#endif // COMPACT_H
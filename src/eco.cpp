@@ -0,0 +1,391 @@
+/****************************************************************************
+  FileName  [ eco.cpp ]
+  Synopsis  [ Implementation of the routed tree kept for incremental changes. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.28 ]
+****************************************************************************/
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cassert>
+#include "eco.h"
+using namespace std;
+
+template <class Coord>
+const Index EcoTree<Coord>::NONE;
+
+// Replace the tree by the given one. With an empty oldId the names are
+// dropped; otherwise point i of the new tree is the old point oldId[i], and
+// every name moves to the new id of its point.
+template <class Coord>
+void EcoTree<Coord>::build(const vector<Pin<Coord> >& pinList, const vector<Edge<Coord> >& treeList,
+                           const vector<Index>& oldId)
+{
+    size_t pinNum = pinList.size();
+    if (oldId.empty()) {
+        _nameMap.clear();
+    }
+    else {
+        vector<Index> newId(_pin.size(), NONE);
+        for (size_t i = 0, end = oldId.size(); i < end; ++i) {
+            newId[oldId[i]] = i;
+        }
+        for (auto it = _nameMap.begin(); it != _nameMap.end(); ++it) {
+            it->second = newId[it->second];
+            assert(it->second != NONE);
+        }
+    }
+
+    _pin = pinList;
+    _alive.assign(pinNum, 1);
+    _nameCount.assign(pinNum, 0);
+    _adj.assign(pinNum, vector<Index>());
+    _mark.assign(pinNum, 0);
+    _free.clear();
+    _termNum = 0;
+    for (auto it = _nameMap.begin(); it != _nameMap.end(); ++it) {
+        if (_nameCount[it->second]++ == 0) ++_termNum;
+    }
+    for (size_t i = 0, end = treeList.size(); i < end; ++i) {
+        this->addEdge(treeList[i]._s, treeList[i]._t);
+    }
+
+    // about two points per cell over the bounding box
+    long minX = LONG_MAX, maxX = LONG_MIN;
+    long minY = LONG_MAX, maxY = LONG_MIN;
+    for (size_t i = 0; i < pinNum; ++i) {
+        minX = min(minX, (long)pinList[i]._x);
+        maxX = max(maxX, (long)pinList[i]._x);
+        minY = min(minY, (long)pinList[i]._y);
+        maxY = max(maxY, (long)pinList[i]._y);
+    }
+    if (pinNum == 0) minX = maxX = minY = maxY = 0;
+    double area = (double)(maxX - minX + 1) * (maxY - minY + 1);
+    _xmin = minX;
+    _ymin = minY;
+    _cellSize = max((long)sqrt(2.0 * area / max(pinNum, (size_t)1)), 1L);
+    _colNum = (maxX - minX) / _cellSize + 1;
+    _rowNum = (maxY - minY) / _cellSize + 1;
+    _cell.assign(_colNum * _rowNum, vector<Index>());
+    for (size_t i = 0; i < pinNum; ++i) {
+        _cell[this->getCell(pinList[i])].push_back(i);
+    }
+    return;
+}
+
+template <class Coord>
+Index EcoTree<Coord>::findName(const string& name) const
+{
+    auto it = _nameMap.find(name);
+    return (it == _nameMap.end())? NONE: it->second;
+}
+
+// Put the name on point p. Returns false if the name is taken.
+template <class Coord>
+bool EcoTree<Coord>::addName(const string& name, size_t p)
+{
+    assert(_alive[p]);
+    if (!_nameMap.insert(make_pair(name, (Index)p)).second) return false;
+    if (_nameCount[p]++ == 0) ++_termNum;
+    return true;
+}
+
+// Take the name off its point, which stays in the tree. Returns the
+// point, or NONE if there is no such name.
+template <class Coord>
+Index EcoTree<Coord>::removeName(const string& name)
+{
+    auto it = _nameMap.find(name);
+    if (it == _nameMap.end()) return NONE;
+    Index p = it->second;
+    _nameMap.erase(it);
+    if (--_nameCount[p] == 0) --_termNum;
+    return p;
+}
+
+// new isolated point
+template <class Coord>
+Index EcoTree<Coord>::addPoint(const Pin<Coord>& pin)
+{
+    Index p;
+    if (!_free.empty()) {
+        p = _free.back();
+        _free.pop_back();
+        _pin[p] = pin;
+        _alive[p] = 1;
+    }
+    else {
+        p = _pin.size();
+        _pin.push_back(pin);
+        _alive.push_back(1);
+        _nameCount.push_back(0);
+        _adj.push_back(vector<Index>());
+        _mark.push_back(0);
+    }
+    _cell[this->getCell(pin)].push_back(p);
+    return p;
+}
+
+template <class Coord>
+void EcoTree<Coord>::addEdge(size_t a, size_t b)
+{
+    assert(a != b);
+    _adj[a].push_back(b);
+    _adj[b].push_back(a);
+    return;
+}
+
+template <class Coord>
+void EcoTree<Coord>::removeEdge(size_t a, size_t b)
+{
+    vector<Index>& adjA = _adj[a];
+    vector<Index>& adjB = _adj[b];
+    auto itA = find(adjA.begin(), adjA.end(), (Index)b);
+    auto itB = find(adjB.begin(), adjB.end(), (Index)a);
+    assert(itA != adjA.end() && itB != adjB.end());
+    *itA = adjA.back();
+    adjA.pop_back();
+    *itB = adjB.back();
+    adjB.pop_back();
+    return;
+}
+
+// Remove the edges inside a piece of getRegion(). The points still wired
+// to the rest of the tree, and the terminals, are returned in keep; the
+// other points of the piece are dropped.
+template <class Coord>
+void EcoTree<Coord>::cutRegion(const vector<Index>& piece, vector<Index>& keep)
+{
+    keep.clear();
+    for (size_t i = 0, end = piece.size(); i < end; ++i) {
+        _mark[piece[i]] = 1;
+    }
+    for (size_t i = 0, end = piece.size(); i < end; ++i) {
+        vector<Index>& adj = _adj[piece[i]];
+        adj.erase(remove_if(adj.begin(), adj.end(), [&](Index q) {
+            return (_mark[q] != 0);
+        }), adj.end());
+    }
+    for (size_t i = 0, end = piece.size(); i < end; ++i) {
+        size_t p = piece[i];
+        _mark[p] = 0;
+        if (_nameCount[p] > 0 || !_adj[p].empty()) {
+            keep.push_back(p);
+        }
+        else {
+            this->killPoint(p);
+        }
+    }
+    return;
+}
+
+// Drop the Steiner points that no longer branch, starting from the points
+// in work: a leaf is removed (and its neighbor checked in turn), a point of
+// degree two is replaced by an edge between its neighbors.
+template <class Coord>
+void EcoTree<Coord>::prune(vector<Index>& work)
+{
+    while (!work.empty()) {
+        size_t p = work.back();
+        work.pop_back();
+        if (!_alive[p] || _nameCount[p] > 0) continue;
+        vector<Index>& adj = _adj[p];
+        if (adj.size() == 1) {
+            size_t q = adj[0];
+            this->removeEdge(p, q);
+            work.push_back(q);
+        }
+        else if (adj.size() == 2) {
+            size_t a = adj[0], b = adj[1];
+            this->removeEdge(p, a);
+            this->removeEdge(p, b);
+            this->addEdge(a, b);
+        }
+        if (adj.empty()) {
+            this->killPoint(p);
+        }
+    }
+    return;
+}
+
+// Nearest live point by ring search over the grid, or NONE. Cells of ring
+// r are at least (r - 1) cells away from the pin. Terminals win ties, so
+// that a pin put on a terminal shares it and no two terminals coincide.
+template <class Coord>
+Index EcoTree<Coord>::findNearest(const Pin<Coord>& pin) const
+{
+    assert(!_cell.empty());
+    size_t cell = this->getCell(pin);
+    long col = cell % _colNum, row = cell / _colNum;
+    Index best = NONE;
+    long bestDist = LONG_MAX;
+    for (long r = 0, end = max(_colNum, _rowNum); r < end; ++r) {
+        if (best != NONE && bestDist <= (r - 1) * _cellSize) break;
+        for (long y = max(row - r, 0L), yEnd = min(row + r, _rowNum - 1); y <= yEnd; ++y) {
+            bool edge = (y == row - r || y == row + r);
+            for (long x = col - r; x <= col + r; x += (edge)? 1: 2 * r) {
+                if (x < 0 || x >= _colNum) continue;
+                const vector<Index>& point = _cell[y * _colNum + x];
+                for (size_t i = 0, iEnd = point.size(); i < iEnd; ++i) {
+                    const Pin<Coord>& q = _pin[point[i]];
+                    long dist = labs((long)q._x - pin._x) + labs((long)q._y - pin._y);
+                    if (dist < bestDist || (dist == bestDist && _nameCount[point[i]] > 0)) {
+                        best = point[i];
+                        bestDist = dist;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+// Points within hopNum tree edges of a live seed, split into the pieces
+// that are connected inside the region. A piece is a subtree, so cutting
+// its edges and spanning its kept points again leaves a tree.
+template <class Coord>
+void EcoTree<Coord>::getRegion(const vector<Index>& seed, size_t hopNum, vector<vector<Index> >& piece)
+{
+    piece.clear();
+    vector<Index> ball;
+    for (size_t i = 0, end = seed.size(); i < end; ++i) {
+        if (_alive[seed[i]] && !_mark[seed[i]]) {
+            _mark[seed[i]] = 1;
+            ball.push_back(seed[i]);
+        }
+    }
+    for (size_t hop = 0, begin = 0; hop < hopNum; ++hop) {
+        size_t end = ball.size();
+        for (size_t i = begin; i < end; ++i) {
+            const vector<Index>& adj = _adj[ball[i]];
+            for (size_t j = 0, jEnd = adj.size(); j < jEnd; ++j) {
+                if (!_mark[adj[j]]) {
+                    _mark[adj[j]] = 1;
+                    ball.push_back(adj[j]);
+                }
+            }
+        }
+        begin = end;
+    }
+
+    for (size_t i = 0, end = ball.size(); i < end; ++i) {
+        if (_mark[ball[i]] != 1) continue;
+        piece.push_back(vector<Index>(1, ball[i]));
+        vector<Index>& member = piece.back();
+        _mark[ball[i]] = 2;
+        for (size_t j = 0; j < member.size(); ++j) {
+            const vector<Index>& adj = _adj[member[j]];
+            for (size_t k = 0, kEnd = adj.size(); k < kEnd; ++k) {
+                if (_mark[adj[k]] == 1) {
+                    _mark[adj[k]] = 2;
+                    member.push_back(adj[k]);
+                }
+            }
+        }
+    }
+    for (size_t i = 0, end = ball.size(); i < end; ++i) {
+        _mark[ball[i]] = 0;
+    }
+    return;
+}
+
+// live terminals and their point ids
+template <class Coord>
+void EcoTree<Coord>::getTerminals(vector<Pin<Coord> >& pinList, vector<Index>& id) const
+{
+    pinList.clear();
+    id.clear();
+    for (size_t p = 0, end = _pin.size(); p < end; ++p) {
+        if (_alive[p] && _nameCount[p] > 0) {
+            pinList.push_back(_pin[p]);
+            id.push_back(p);
+        }
+    }
+    return;
+}
+
+// The tree in the layout of Router: terminals first, then the Steiner
+// points; one name per terminal, the other names as duplicates (see
+// Router::dedupPins()). Names are views into the name table, valid until
+// the name is removed. Returns the number of terminals.
+template <class Coord>
+size_t EcoTree<Coord>::getTree(vector<Pin<Coord> >& pinList, vector<StrView>& pinName,
+                               vector<Index>& dupPin, vector<Edge<Coord> >& treeList) const
+{
+    size_t slotNum = _pin.size();
+    vector<Index> newId(slotNum, NONE);
+    pinList.clear();
+    for (size_t p = 0; p < slotNum; ++p) {
+        if (_alive[p] && _nameCount[p] > 0) {
+            newId[p] = pinList.size();
+            pinList.push_back(_pin[p]);
+        }
+    }
+    size_t uPinNum = pinList.size();
+    for (size_t p = 0; p < slotNum; ++p) {
+        if (_alive[p] && _nameCount[p] == 0) {
+            newId[p] = pinList.size();
+            pinList.push_back(_pin[p]);
+        }
+    }
+
+    pinName.assign(uPinNum, StrView());
+    dupPin.clear();
+    vector<StrView> dupName;
+    for (auto it = _nameMap.begin(); it != _nameMap.end(); ++it) {
+        size_t p = newId[it->second];
+        StrView name(it->first.data(), it->first.size());
+        if (pinName[p]._str == 0) {
+            pinName[p] = name;
+        }
+        else {
+            dupPin.push_back(p);
+            dupName.push_back(name);
+        }
+    }
+    pinName.insert(pinName.end(), dupName.begin(), dupName.end());
+
+    treeList.clear();
+    for (size_t p = 0; p < slotNum; ++p) {
+        if (!_alive[p]) continue;
+        const vector<Index>& adj = _adj[p];
+        for (size_t i = 0, end = adj.size(); i < end; ++i) {
+            if (p > adj[i]) continue;
+            const Pin<Coord>& s = _pin[p];
+            const Pin<Coord>& t = _pin[adj[i]];
+            Coord cost = abs(s._x - t._x) + abs(s._y - t._y);
+            treeList.push_back(Edge<Coord>(newId[p], newId[adj[i]], cost));
+        }
+    }
+    return uPinNum;
+}
+
+// grid cell of a pin, clamped to the grid
+template <class Coord>
+size_t EcoTree<Coord>::getCell(const Pin<Coord>& pin) const
+{
+    long col = ((long)pin._x - _xmin) / _cellSize;
+    long row = ((long)pin._y - _ymin) / _cellSize;
+    col = min(max(col, 0L), _colNum - 1);
+    row = min(max(row, 0L), _rowNum - 1);
+    return row * _colNum + col;
+}
+
+template <class Coord>
+void EcoTree<Coord>::killPoint(size_t p)
+{
+    assert(_alive[p] && _adj[p].empty() && _nameCount[p] == 0);
+    vector<Index>& point = _cell[this->getCell(_pin[p])];
+    auto it = find(point.begin(), point.end(), (Index)p);
+    assert(it != point.end());
+    *it = point.back();
+    point.pop_back();
+    _alive[p] = 0;
+    _free.push_back(p);
+    return;
+}
+
+// coordinate widths picked by getCoordWidth()
+template class EcoTree<int16_t>;
+template class EcoTree<int32_t>;
+template class EcoTree<int64_t>;
@@ -0,0 +1,80 @@
+/****************************************************************************
+  FileName  [ eco.h ]
+  Synopsis  [ Define the routed tree kept for incremental changes. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.28 ]
+****************************************************************************/
+#ifndef ECO_H
+#define ECO_H
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "module.h"
+using namespace std;
+
+// The Steiner tree of a routed net, kept editable between incremental
+// changes (ECO). Points are the pins and the Steiner points; a point is a
+// terminal while at least one pin name sits on it. Slots of dead points
+// are reused. A uniform grid over the points answers nearest point
+// queries, so that a new pin can be hooked to the tree without a sweep.
+template <class Coord>
+class EcoTree
+{
+public:
+    // constructor and destructor
+    EcoTree() : _termNum(0), _cellSize(1), _colNum(0), _rowNum(0) {}
+    ~EcoTree() {}
+
+    // basic access methods
+    size_t size() const                 { return _pin.size(); }
+    bool isAlive(size_t p) const        { return _alive[p]; }
+    bool isTerminal(size_t p) const     { return (_nameCount[p] > 0); }
+    const Pin<Coord>& getPin(size_t p) const    { return _pin[p]; }
+    const vector<Index>& getAdj(size_t p) const { return _adj[p]; }
+    size_t getNameNum() const           { return _nameMap.size(); }
+    size_t getTermNum() const           { return _termNum; }
+    Index findName(const string& name) const;
+
+    // modify methods
+    void build(const vector<Pin<Coord> >& pinList, const vector<Edge<Coord> >& treeList,
+               const vector<Index>& oldId);
+    bool addName(const string& name, size_t p);
+    Index removeName(const string& name);
+    Index addPoint(const Pin<Coord>& pin);
+    void addEdge(size_t a, size_t b);
+    void removeEdge(size_t a, size_t b);
+    void cutRegion(const vector<Index>& piece, vector<Index>& keep);
+    void prune(vector<Index>& work);
+
+    // query methods
+    Index findNearest(const Pin<Coord>& pin) const;
+    void getRegion(const vector<Index>& seed, size_t hopNum, vector<vector<Index> >& piece);
+    void getTerminals(vector<Pin<Coord> >& pinList, vector<Index>& id) const;
+    size_t getTree(vector<Pin<Coord> >& pinList, vector<StrView>& pinName,
+                   vector<Index>& dupPin, vector<Edge<Coord> >& treeList) const;
+
+    static const Index NONE = (Index)-1;
+
+private:
+    vector<Pin<Coord> >     _pin;       // coordinates of every point slot
+    vector<uint8_t>         _alive;     // slot holds a point of the tree
+    vector<uint32_t>        _nameCount; // pin names on each point
+    vector<vector<Index> >  _adj;       // tree neighbors of each point
+    vector<Index>           _free;      // dead slots
+    vector<uint8_t>         _mark;      // scratch flags, all 0 between calls
+    unordered_map<string, Index> _nameMap;  // point of each pin name
+    size_t                  _termNum;   // number of terminal points
+    long                    _xmin;      // grid origin
+    long                    _ymin;      // grid origin
+    long                    _cellSize;  // side of a grid cell
+    long                    _colNum;    // number of grid columns
+    long                    _rowNum;    // number of grid rows
+    vector<vector<Index> >  _cell;      // live points of each grid cell
+
+    // private member functions
+    size_t getCell(const Pin<Coord>& pin) const;
+    void killPoint(size_t p);
+};
+
+#endif // ECO_H
@@ -0,0 +1,145 @@
+/****************************************************************************
+  FileName  [ gainKernel.cpp ]
+  Synopsis  [ Implementation of the batched gain kernel. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.26 ]
+****************************************************************************/
+#include <algorithm>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "gainKernel.h"
+using namespace std;
+
+// scalar kernel, used for every width and for the tail of the SIMD loops
+template <class Coord>
+static size_t computeGainScalar(const QueryBatch<Coord>& batch, size_t begin, size_t end,
+                                Index* id, Coord* gain)
+{
+    size_t num = 0;
+    for (size_t i = begin; i < end; ++i) {
+        Coord maxX = max(batch._sx[i], batch._tx[i]);
+        Coord minX = min(batch._sx[i], batch._tx[i]);
+        Coord maxY = max(batch._sy[i], batch._ty[i]);
+        Coord minY = min(batch._sy[i], batch._ty[i]);
+        Coord x = batch._x[i], y = batch._y[i];
+        Coord g = batch._cost[i];
+        g -= max((Coord)(x - maxX), (Coord)0) + max((Coord)(minX - x), (Coord)0);
+        g -= max((Coord)(y - maxY), (Coord)0) + max((Coord)(minY - y), (Coord)0);
+        id[num] = i;
+        gain[num] = g;
+        num += (g > 0);
+    }
+    return num;
+}
+
+template <class Coord>
+size_t computeGain(const QueryBatch<Coord>& batch, size_t begin, size_t end,
+                   Index* id, Coord* gain)
+{
+    return computeGainScalar(batch, begin, end, id, gain);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static size_t computeGainAvx2(const QueryBatch<int32_t>& batch, size_t begin, size_t end,
+                              Index* id, int32_t* gain)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    size_t num = 0;
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i x  = _mm256_loadu_si256((const __m256i*)&batch._x[i]);
+        __m256i y  = _mm256_loadu_si256((const __m256i*)&batch._y[i]);
+        __m256i sx = _mm256_loadu_si256((const __m256i*)&batch._sx[i]);
+        __m256i sy = _mm256_loadu_si256((const __m256i*)&batch._sy[i]);
+        __m256i tx = _mm256_loadu_si256((const __m256i*)&batch._tx[i]);
+        __m256i ty = _mm256_loadu_si256((const __m256i*)&batch._ty[i]);
+        __m256i g  = _mm256_loadu_si256((const __m256i*)&batch._cost[i]);
+
+        __m256i dx = _mm256_add_epi32(
+            _mm256_max_epi32(_mm256_sub_epi32(x, _mm256_max_epi32(sx, tx)), zero),
+            _mm256_max_epi32(_mm256_sub_epi32(_mm256_min_epi32(sx, tx), x), zero));
+        __m256i dy = _mm256_add_epi32(
+            _mm256_max_epi32(_mm256_sub_epi32(y, _mm256_max_epi32(sy, ty)), zero),
+            _mm256_max_epi32(_mm256_sub_epi32(_mm256_min_epi32(sy, ty), y), zero));
+        g = _mm256_sub_epi32(g, _mm256_add_epi32(dx, dy));
+
+        // keep the positive lanes
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(g, zero)));
+        if (mask == 0) continue;
+        alignas(32) int32_t lane[8];
+        _mm256_store_si256((__m256i*)lane, g);
+        while (mask) {
+            int k = __builtin_ctz(mask);
+            id[num] = i + k;
+            gain[num] = lane[k];
+            ++num;
+            mask &= mask - 1;
+        }
+    }
+    return num + computeGainScalar(batch, i, end, id + num, gain + num);
+}
+
+__attribute__((target("sse4.1")))
+static size_t computeGainSse41(const QueryBatch<int32_t>& batch, size_t begin, size_t end,
+                               Index* id, int32_t* gain)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t num = 0;
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128i x  = _mm_loadu_si128((const __m128i*)&batch._x[i]);
+        __m128i y  = _mm_loadu_si128((const __m128i*)&batch._y[i]);
+        __m128i sx = _mm_loadu_si128((const __m128i*)&batch._sx[i]);
+        __m128i sy = _mm_loadu_si128((const __m128i*)&batch._sy[i]);
+        __m128i tx = _mm_loadu_si128((const __m128i*)&batch._tx[i]);
+        __m128i ty = _mm_loadu_si128((const __m128i*)&batch._ty[i]);
+        __m128i g  = _mm_loadu_si128((const __m128i*)&batch._cost[i]);
+
+        __m128i dx = _mm_add_epi32(
+            _mm_max_epi32(_mm_sub_epi32(x, _mm_max_epi32(sx, tx)), zero),
+            _mm_max_epi32(_mm_sub_epi32(_mm_min_epi32(sx, tx), x), zero));
+        __m128i dy = _mm_add_epi32(
+            _mm_max_epi32(_mm_sub_epi32(y, _mm_max_epi32(sy, ty)), zero),
+            _mm_max_epi32(_mm_sub_epi32(_mm_min_epi32(sy, ty), y), zero));
+        g = _mm_sub_epi32(g, _mm_add_epi32(dx, dy));
+
+        // keep the positive lanes
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(g, zero)));
+        if (mask == 0) continue;
+        alignas(16) int32_t lane[4];
+        _mm_store_si128((__m128i*)lane, g);
+        while (mask) {
+            int k = __builtin_ctz(mask);
+            id[num] = i + k;
+            gain[num] = lane[k];
+            ++num;
+            mask &= mask - 1;
+        }
+    }
+    return num + computeGainScalar(batch, i, end, id + num, gain + num);
+}
+#endif
+
+// the kernel is picked once, by what the running CPU supports
+template <>
+size_t computeGain(const QueryBatch<int32_t>& batch, size_t begin, size_t end,
+                   Index* id, int32_t* gain)
+{
+    typedef size_t (*Kernel)(const QueryBatch<int32_t>&, size_t, size_t, Index*, int32_t*);
+    static const Kernel kernel = []() -> Kernel {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return computeGainAvx2;
+        if (__builtin_cpu_supports("sse4.1")) return computeGainSse41;
+#endif
+        return computeGainScalar<int32_t>;
+    }();
+    return kernel(batch, begin, end, id, gain);
+}
+
+// coordinate widths picked by getCoordWidth()
+template size_t computeGain(const QueryBatch<int16_t>&, size_t, size_t, Index*, int16_t*);
+template size_t computeGain(const QueryBatch<int64_t>&, size_t, size_t, Index*, int64_t*);
@@ -0,0 +1,57 @@
+/****************************************************************************
+  FileName  [ gainKernel.h ]
+  Synopsis  [ Define the batched gain kernel for Steiner candidate queries. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.26 ]
+****************************************************************************/
+#ifndef GAINKERNEL_H
+#define GAINKERNEL_H
+
+#include <vector>
+#include "module.h"
+using namespace std;
+
+// Candidate queries gathered into contiguous arrays: w = (x, y), the ends
+// of the cEdge (sx, sy), (tx, ty) and the cost of the dEdge. A query whose
+// dEdge is its cEdge gets cost 0, so its gain can never be positive.
+template <class Coord>
+class QueryBatch
+{
+public:
+    // constructor and destructor
+    QueryBatch() {}
+    ~QueryBatch() {}
+
+    // basic access methods
+    size_t size() const { return _x.size(); }
+
+    // modify methods
+    void resize(size_t n) {
+        _x.resize(n);   _y.resize(n);
+        _sx.resize(n);  _sy.resize(n);
+        _tx.resize(n);  _ty.resize(n);
+        _cost.resize(n);
+    }
+
+    // data members
+    vector<Coord>   _x;         // x-coordinate of w
+    vector<Coord>   _y;         // y-coordinate of w
+    vector<Coord>   _sx;        // x-coordinate of the cEdge source
+    vector<Coord>   _sy;        // y-coordinate of the cEdge source
+    vector<Coord>   _tx;        // x-coordinate of the cEdge sink
+    vector<Coord>   _ty;        // y-coordinate of the cEdge sink
+    vector<Coord>   _cost;      // cost of the dEdge
+};
+
+// Gain of every entry in [begin, end): the dEdge cost minus the distance
+// from w to the bounding box of the cEdge. Entries with a positive gain
+// are written as (index, gain) to id and gain, in order; the count is
+// returned. The 32-bit kernel uses AVX2 or SSE4.1 when the CPU has them.
+template <class Coord>
+size_t computeGain(const QueryBatch<Coord>& batch, size_t begin, size_t end,
+                   Index* id, Coord* gain);
+template <>
+size_t computeGain(const QueryBatch<int32_t>& batch, size_t begin, size_t end,
+                   Index* id, int32_t* gain);
+
+#endif // GAINKERNEL_H
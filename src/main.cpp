@@ -6,36 +6,156 @@
 ****************************************************************************/
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <cstdlib>
 #include "router.h"
+#include "netRouter.h"
+#include "batchRouter.h"
+#include "parser.h"
 using namespace std;
 
+void usage()
+{
+    cerr << "Usage: ./Router [-batch] [-thread <num>] [-sweep multimap|fenwick] "
+         << "[-mst kruskal|filter] [-steiner greedy|batch] [-tol <ratio>] "
+         << "[-pass <num>] [-passgain <ratio>] [-compact on|off] "
+         << "[-order input|hilbert] [-tile <size>] [-multilevel] [-flatcmp] "
+         << "[-eco <change file>] [-reroute <ratio>] "
+         << "<input file> <output file> " << endl;
+    exit(1);
+}
+
 int main(int argc, char** argv)
 {
-    fstream input, output;
+    MappedFile input;
+    fstream output;
+    bool batch = false;
+    size_t threadNum = 0;
+    bool threadSet = false;
+    RouterOption option;
+    vector<char*> files;
+    char* changeFile = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-batch") {
+            batch = true;
+        }
+        else if (arg == "-thread" && i + 1 < argc) {
+            threadNum = atoi(argv[++i]);
+            threadSet = true;
+        }
+        else if (arg == "-sweep" && i + 1 < argc) {
+            string sweep = argv[++i];
+            if (sweep != "multimap" && sweep != "fenwick") usage();
+            option._fenwickSweep = (sweep == "fenwick");
+        }
+        else if (arg == "-mst" && i + 1 < argc) {
+            string mst = argv[++i];
+            if (mst != "kruskal" && mst != "filter") usage();
+            option._filterKruskal = (mst == "filter");
+        }
+        else if (arg == "-steiner" && i + 1 < argc) {
+            string steiner = argv[++i];
+            if (steiner != "greedy" && steiner != "batch") usage();
+            option._batchSteiner = (steiner == "batch");
+        }
+        else if (arg == "-tol" && i + 1 < argc) {
+            option._steinerTol = atof(argv[++i]);
+            if (option._steinerTol < 0) usage();
+        }
+        else if (arg == "-pass" && i + 1 < argc) {
+            option._steinerPass = atoi(argv[++i]);
+            if (option._steinerPass < 1) usage();
+        }
+        else if (arg == "-passgain" && i + 1 < argc) {
+            option._passGain = atof(argv[++i]);
+            if (option._passGain < 0) usage();
+        }
+        else if (arg == "-compact" && i + 1 < argc) {
+            string compact = argv[++i];
+            if (compact != "on" && compact != "off") usage();
+            option._compact = (compact == "on");
+        }
+        else if (arg == "-order" && i + 1 < argc) {
+            string order = argv[++i];
+            if (order != "input" && order != "hilbert") usage();
+            option._hilbertOrder = (order == "hilbert");
+        }
+        else if (arg == "-tile" && i + 1 < argc) {
+            option._tileSize = atol(argv[++i]);
+            if (option._tileSize < 0) usage();
+        }
+        else if (arg == "-multilevel") {
+            option._multilevel = true;
+        }
+        else if (arg == "-flatcmp") {
+            option._flatCompare = true;
+        }
+        else if (arg == "-eco" && i + 1 < argc) {
+            changeFile = argv[++i];
+            option._incremental = true;
+        }
+        else if (arg == "-reroute" && i + 1 < argc) {
+            option._rerouteRatio = atof(argv[++i]);
+            if (option._rerouteRatio < 0) usage();
+        }
+        else if (arg[0] == '-') {
+            usage();
+        }
+        else {
+            files.push_back(argv[i]);
+        }
+    }
 
-    if (argc == 3) {
-        input.open(argv[1], ios::in);
-        output.open(argv[2], ios::out);
-        if (!input) {
-            cerr << "Cannot open the input file \"" << argv[1]
+    if (files.size() == 2) {
+        bool opened = input.open(files[0]);
+        output.open(files[1], ios::out);
+        if (!opened) {
+            cerr << "Cannot open the input file \"" << files[0]
                  << "\". The program will be terminated..." << endl;
             exit(1);
         }
         if (!output) {
-            cerr << "Cannot open the output file \"" << argv[2]
+            cerr << "Cannot open the output file \"" << files[1]
                  << "\". The program will be terminated..." << endl;
             exit(1);
         }
     }
     else {
-        cerr << "Usage: ./Router <input file> <output file> " << endl;
-        exit(1);
+        usage();
+    }
+
+    if (batch) {
+        if (changeFile != 0) usage();
+        BatchRouter batchRouter(threadNum, option);
+        batchRouter.parseInput(input.begin(), input.end());
+        batchRouter.route();
+        batchRouter.printSummary();
+        batchRouter.writeResult(output);
+        return 0;
     }
 
-    Router* router = new Router(input);
+    // one thread per net unless -thread is given
+    if (threadSet) option._threadNum = threadNum;
+    NetRouter netRouter(option);
+    RouterBase* router = netRouter.getRouter(getCoordWidth(input.begin(), input.end()));
+    router->parseInput(input.begin(), input.end());
     router->route();
-    router->writeResult(output);
-    // router->drawResult(argv[2]);
+    if (changeFile != 0) {
+        MappedFile change;
+        if (!change.open(changeFile)) {
+            cerr << "Cannot open the change file \"" << changeFile
+                 << "\". The program will be terminated..." << endl;
+            exit(1);
+        }
+        router->applyChange(change.begin(), change.end());
+    }
+    router->printSummary();
+    Writer writer(output);
+    router->writeResult(writer);
+    writer.flush();
+    // router->drawResult(files[1]);
     // router->reportPin();
     // router->reportEdge();
 
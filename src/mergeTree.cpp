@@ -5,14 +5,23 @@
   Date      [ 2017.6.15 ]
 ****************************************************************************/
 #include <numeric>
+#include <cstdlib>
+#include <type_traits>
 #include <iostream>
 #include <cassert>
 #include <algorithm>
 #include "mergeTree.h"
+#include "radixSort.h"
+#include "parallel.h"
 using namespace std;
 
-MergeTree::MergeTree(const vector<Pin>& pinList) :
-    _pinList(pinList), _mergeCount(pinList.size())
+// The queries and their index by pin are scratch of the net, taken from
+// arena.
+template <class Coord>
+MergeTree<Coord>::MergeTree(const vector<Pin<Coord> >& pinList, const vector<Edge<Coord> >& edgeList,
+                            Arena& arena) :
+    _pinList(pinList), _edgeList(edgeList), _arena(arena), _mergeCount(pinList.size()),
+    _queryList(&arena), _queryStart(&arena), _queryId(&arena)
 {
     size_t pinNum = _pinList.size();
 
@@ -25,13 +34,11 @@ MergeTree::MergeTree(const vector<Pin>& pinList) :
     _mergeRoot.resize(pinNum);
     iota(_mergePar.begin(), _mergePar.end(), 0);
     iota(_mergeRoot.begin(), _mergeRoot.end(), 0);
-
-    // query setup
-    _queryId.resize(pinNum);
 }
 
 // disjoint-set operations
-void MergeTree::makeSet(size_t n)
+template <class Coord>
+void MergeTree<Coord>::makeSet(size_t n)
 {
     _par.resize(n);
     _rank.resize(n);
@@ -40,7 +47,8 @@ void MergeTree::makeSet(size_t n)
     return;
 }
 
-void MergeTree::unionSet(size_t x, size_t y, size_t t)
+template <class Coord>
+void MergeTree<Coord>::unionSet(size_t x, size_t y, size_t t)
 {
     if (_rank[x] < _rank[y]) {
         _par[x] = y;
@@ -58,121 +66,341 @@ void MergeTree::unionSet(size_t x, size_t y, size_t t)
     return;
 }
 
-bool MergeTree::sameSet(size_t x, size_t y)
+// with path compression
+template <class Coord>
+size_t MergeTree<Coord>::findSet(size_t x)
 {
-    return (findSet(x) == findSet(y));
-}
-
-size_t MergeTree::findSet(size_t x)
-{
-    if (_par[x] == x) return x;
-    return findSet(_par[x]);
+    size_t root = x;
+    while (_par[root] != root) root = _par[root];
+    while (_par[x] != root) {
+        size_t next = _par[x];
+        _par[x] = root;
+        x = next;
+    }
+    return root;
 }
 
 // binary merging tree operations
-void MergeTree::addEdge(const Edge& edge)
+template <class Coord>
+void MergeTree<Coord>::addEdge(size_t edge)
 {
-    size_t x = findSet(edge._s);
-    size_t y = findSet(edge._t);
+    size_t x = findSet(_edgeList[edge]._s);
+    size_t y = findSet(_edgeList[edge]._t);
     size_t xRoot = _mergeRoot[x];
     size_t yRoot = _mergeRoot[y];
     this->unionSet(x, y, _mergeCount);
+    _mergePar[xRoot] = _mergeCount;
+    _mergePar[yRoot] = _mergeCount;
     _mergeTree[_mergeCount++] = Node(edge, xRoot, yRoot);
 
     return;
 }
 
-size_t MergeTree::findLca(size_t x)
+// Post-order by an explicit stack: visiting node, right, left and then
+// reversing gives left, right, node. The stack lives on the heap, so deep
+// (skewed) merging trees cannot overflow the call stack.
+template <class Coord>
+void MergeTree<Coord>::buildPostOrder()
+{
+    size_t root = _mergeCount - 1;
+    _postOrder.clear();
+    _postOrder.reserve(_mergeCount);
+    vector<Index> stack(1, root);
+    while (!stack.empty()) {
+        size_t idx = stack.back();
+        stack.pop_back();
+        _postOrder.push_back(idx);
+        if (idx >= _pinList.size()) {
+            stack.push_back(_mergeTree[idx]._left);
+            stack.push_back(_mergeTree[idx]._right);
+        }
+    }
+    reverse(_postOrder.begin(), _postOrder.end());
+
+    size_t nodeNum = _postOrder.size();
+    _postPos.resize(_mergeTree.size());
+    for (size_t i = 0; i < nodeNum; ++i) {
+        _postPos[_postOrder[i]] = i;
+    }
+    _postPar.resize(nodeNum);
+    for (size_t i = 0; i < nodeNum; ++i) {
+        _postPar[i] = _postPos[_mergePar[_postOrder[i]]];
+    }
+    return;
+}
+
+// lowest ancestor of position x that is still being visited
+template <class Coord>
+size_t MergeTree<Coord>::findLca(size_t x)
+{
+    return _ancestor[findLcaSet(x)];
+}
+
+// with path compression
+template <class Coord>
+size_t MergeTree<Coord>::findLcaSet(size_t x)
 {
-    if (_mergePar[x] == x) return x;
-    return findLca(_mergePar[x]);
+    size_t root = x;
+    while (_lcaPar[root] != root) root = _lcaPar[root];
+    while (_lcaPar[x] != root) {
+        size_t next = _lcaPar[x];
+        _lcaPar[x] = root;
+        x = next;
+    }
+    return root;
+}
+
+// union by rank, the merged set is represented by the ancestor of x
+template <class Coord>
+void MergeTree<Coord>::unionLcaSet(size_t x, size_t y)
+{
+    size_t anc = x;
+    x = findLcaSet(x);
+    y = findLcaSet(y);
+    if (x == y) return;
+    if (_lcaRank[x] < _lcaRank[y]) {
+        _lcaPar[x] = y;
+    }
+    else if (_lcaRank[x] > _lcaRank[y]) {
+        _lcaPar[y] = x;
+    }
+    else {
+        _lcaPar[x] = y;
+        _lcaRank[y] += 1;
+    }
+    _ancestor[findLcaSet(x)] = anc;
+    return;
 }
 
 // query operations
-void MergeTree::addQuery(size_t w, size_t u, const Edge& edge)
+// Room for queryNum queries, so that adding them never reallocates.
+template <class Coord>
+void MergeTree<Coord>::reserveQuery(size_t queryNum)
 {
-    _queryList.push_back(Query(w, u, edge));
-    _queryId[w].push_back(_queryList.size() - 1);
-    _queryId[u].push_back(_queryList.size() - 1);
+    _queryList.reserve(queryNum);
+    return;
+}
 
+template <class Coord>
+void MergeTree<Coord>::addQuery(size_t w, size_t u, size_t edge)
+{
+    _queryList.push_back(Query<Coord>(w, u, edge));
     return;
 }
 
-void MergeTree::answerQuery()
+// Index the queries by pin in two counting passes, each pin listing its
+// queries in the order they were added.
+template <class Coord>
+void MergeTree<Coord>::buildQueryIndex()
 {
-    answerQueryRec(_mergeCount - 1);
-    for (size_t i = 0, end = _queryList.size(); i < end; ++i) {
-        Query& query = _queryList[i];
-        const Edge& cEdge = query._cEdge;
-        const Edge& dEdge = query._dEdge;
-        getQueryGain(query, cEdge, dEdge);
+    size_t pinNum = _pinList.size();
+    size_t queryNum = _queryList.size();
+    _queryStart.assign(pinNum + 1, 0);
+    for (size_t q = 0; q < queryNum; ++q) {
+        ++_queryStart[_queryList[q]._w + 1];
+        ++_queryStart[_queryList[q]._u + 1];
+    }
+    partial_sum(_queryStart.begin(), _queryStart.end(), _queryStart.begin());
+
+    ArenaVector<size_t> next(_queryStart.begin(), _queryStart.end() - 1, &_arena);
+    _queryId.resize(2 * queryNum);
+    for (size_t q = 0; q < queryNum; ++q) {
+        _queryId[next[_queryList[q]._w]++] = q;
+        _queryId[next[_queryList[q]._u]++] = q;
     }
     return;
 }
 
-void MergeTree::answerQueryRec(size_t idx)
+static const Index NO_TASK = (Index)-1;
+
+// Walk the merging tree in post-order. A leaf answers the queries whose
+// other end was visited before, then every finished node joins the set of
+// its parent (Tarjan's offline lca).
+template <class Coord>
+void MergeTree<Coord>::answerQuery(size_t threadNum)
 {
-    if (idx < _pinList.size()) {
-        // vertice
-        for (size_t i = 0, end = _queryId[idx].size(); i < end; ++i) {
-            Query& query = _queryList[_queryId[idx][i]];
-            query._c += 1;
-            if (query._c == 2) {
-                size_t n = (idx == query._w)? query._u: query._w;
-                size_t lca = findLca(n);
-                query._dEdge = _mergeTree[lca]._edge;
-            }
-        }
+    this->buildPostOrder();
+    this->buildQueryIndex();
+
+    size_t nodeNum = _postOrder.size();
+    _lcaPar.resize(nodeNum);
+    _lcaRank.assign(nodeNum, 0);
+    _ancestor.resize(nodeNum);
+    iota(_lcaPar.begin(), _lcaPar.end(), 0);
+    iota(_ancestor.begin(), _ancestor.end(), 0);
+
+    if (threadNum > 1 && nodeNum >= (1 << 14)) {
+        this->answerQueryParallel(threadNum);
     }
     else {
-        // edge
-        answerQueryRec(_mergeTree[idx]._left);
-        _mergePar[_mergeTree[idx]._left] = idx;
-        answerQueryRec(_mergeTree[idx]._right);
-        _mergePar[_mergeTree[idx]._right] = idx;
+        this->answerRange(0, nodeNum - 1, false);
     }
 
+    this->computeQueryGain((_queryList.size() < (1 << 14))? 1: threadNum);
     return;
 }
 
-void MergeTree::getQueryList(vector<Query>& queryList) const
+// Tarjan's walk over the positions [lo, hi], the subtree rooted at hi. If
+// local is set, only queries with both ends in the same task are answered.
+template <class Coord>
+void MergeTree<Coord>::answerRange(size_t lo, size_t hi, bool local)
 {
-    queryList.clear();
-    for (size_t i = 0, end = _queryList.size(); i < end; ++i) {
-        if (_queryList[i]._gain > 0) {
-            queryList.push_back(_queryList[i]);
+    for (size_t i = lo; i <= hi; ++i) {
+        size_t idx = _postOrder[i];
+        if (idx < _pinList.size()) {
+            for (size_t j = _queryStart[idx], end = _queryStart[idx + 1]; j < end; ++j) {
+                Query<Coord>& query = _queryList[_queryId[j]];
+                size_t n = (idx == query._w)? query._u: query._w;
+                if (local && _postTask[_postPos[n]] != _postTask[i]) continue;
+                query._c += 1;
+                if (query._c == 2) {
+                    size_t lca = findLca(_postPos[n]);
+                    query._dEdge = _mergeTree[_postOrder[lca]]._edge;
+                }
+            }
+        }
+        if (i != hi) {
+            unionLcaSet(_postPar[i], i);
         }
     }
-    sort(queryList.begin(), queryList.end(), SortQueryGain());
+    return;
+}
 
+// The merging tree is cut into maximal subtrees of at most grain nodes.
+// A subtree is a contiguous range of post-order positions and touches only
+// its own disjoint-set entries, so the subtrees are answered as independent
+// tasks. Queries across two subtrees have their lca above the cut; they are
+// answered afterwards by one walk over the top of the tree in which every
+// subtree is contracted into a leaf. The answers equal the sequential ones.
+template <class Coord>
+void MergeTree<Coord>::answerQueryParallel(size_t threadNum)
+{
+    size_t nodeNum = _postOrder.size();
+    size_t grain = max(nodeNum / (threadNum * 16), (size_t)1024);
+
+    // subtree sizes and the cut
+    vector<Index> size(nodeNum, 1);
+    for (size_t i = 0; i < nodeNum; ++i) {
+        if (i + 1 < nodeNum) size[_postPar[i]] += size[i];
+    }
+    _postTask.assign(nodeNum, NO_TASK);
+    _taskLo.clear();
+    _taskHi.clear();
+    for (size_t i = 0; i < nodeNum; ++i) {
+        if (size[i] <= grain && (i + 1 == nodeNum || size[_postPar[i]] > grain)) {
+            size_t lo = i + 1 - size[i];
+            fill(_postTask.begin() + lo, _postTask.begin() + i + 1, (Index)_taskLo.size());
+            _taskLo.push_back(lo);
+            _taskHi.push_back(i);
+        }
+    }
+    size_t taskNum = _taskLo.size();
+
+    // local queries
+    workStealingRun(taskNum, threadNum, [&](size_t t) {
+        this->answerRange(_taskLo[t], _taskHi[t], true);
+    });
+
+    // cross queries, listed at both of their tasks
+    vector<vector<Index> > crossId(taskNum);
+    for (size_t q = 0, end = _queryList.size(); q < end; ++q) {
+        size_t tw = _postTask[_postPos[_queryList[q]._w]];
+        size_t tu = _postTask[_postPos[_queryList[q]._u]];
+        if (tw != tu) {
+            crossId[tw].push_back(q);
+            crossId[tu].push_back(q);
+        }
+    }
+
+    for (size_t i = 0; i < nodeNum; ++i) {
+        size_t t = _postTask[i];
+        if (t != NO_TASK) {
+            // contracted subtree
+            i = _taskHi[t];
+            for (size_t j = 0, end = crossId[t].size(); j < end; ++j) {
+                Query<Coord>& query = _queryList[crossId[t][j]];
+                size_t n = (_postTask[_postPos[query._w]] == t)? query._u: query._w;
+                query._c += 1;
+                if (query._c == 2) {
+                    size_t lca = findLca(_postPos[n]);
+                    query._dEdge = _mergeTree[_postOrder[lca]]._edge;
+                }
+            }
+        }
+        if (i + 1 != nodeNum) {
+            unionLcaSet(_postPar[i], i);
+        }
+    }
     return;
 }
 
-// private member functions
-bool MergeTree::sameEdge(const Edge& e1, const Edge& e2)
+// queries with positive gain, in stable order of decreasing gain
+template <class Coord>
+void MergeTree<Coord>::getQueryList(vector<Query<Coord> >& queryList, size_t threadNum) const
 {
-    return (e1._s == e2._s && e1._t == e2._t);
+    typedef typename make_unsigned<Coord>::type UCoord;
+    Coord maxGain = 0;
+    queryList.resize(_gainId.size());
+    for (size_t i = 0, end = _gainId.size(); i < end; ++i) {
+        queryList[i] = _queryList[_gainId[i]];
+        maxGain = max(maxGain, queryList[i]._gain);
+    }
+    radixSort(queryList, [=](const Query<Coord>& query) {
+        return (UCoord)(maxGain - query._gain);
+    }, threadNum);
+
+    return;
 }
 
-void MergeTree::getQueryGain(Query& query, const Edge& cEdge, const Edge& dEdge)
+// private member functions
+// The answered queries are gathered into a QueryBatch and their gains are
+// computed chunk by chunk by computeGain(). Each chunk keeps its positive
+// queries in place; the chunks are then joined in order into _gainId.
+template <class Coord>
+void MergeTree<Coord>::computeQueryGain(size_t threadNum)
 {
-    if (sameEdge(cEdge, dEdge)) {
-        query._gain = -1;
+    size_t queryNum = _queryList.size();
+    if (queryNum == 0) {
+        _gainId.clear();
         return;
     }
+    size_t chunkNum = max((size_t)1, min(threadNum, queryNum));
+    _batch.resize(queryNum);
+    _gainId.resize(queryNum);
+    vector<Coord> gain(queryNum);
+    vector<size_t> count(chunkNum);
 
-    int x = _pinList[query._w]._x;
-    int y = _pinList[query._w]._y;
-    int sx = _pinList[cEdge._s]._x;
-    int sy = _pinList[cEdge._s]._y;
-    int tx = _pinList[cEdge._t]._x;
-    int ty = _pinList[cEdge._t]._y;
-
-    query._gain = dEdge._cost;
-    query._gain -= (x > max(sx, tx))? abs(x - max(sx, tx)): 0;
-    query._gain -= (x < min(sx, tx))? abs(x - min(sx, tx)): 0;
-    query._gain -= (y > max(sy, ty))? abs(y - max(sy, ty)): 0;
-    query._gain -= (y < min(sy, ty))? abs(y - min(sy, ty)): 0;
+    parallelRun(chunkNum, chunkNum, [&](size_t t) {
+        size_t begin = queryNum * t / chunkNum;
+        size_t end = queryNum * (t + 1) / chunkNum;
+        for (size_t i = begin; i < end; ++i) {
+            const Query<Coord>& query = _queryList[i];
+            const Edge<Coord>& cEdge = _edgeList[query._cEdge];
+            _batch._x[i] = _pinList[query._w]._x;
+            _batch._y[i] = _pinList[query._w]._y;
+            _batch._sx[i] = _pinList[cEdge._s]._x;
+            _batch._sy[i] = _pinList[cEdge._s]._y;
+            _batch._tx[i] = _pinList[cEdge._t]._x;
+            _batch._ty[i] = _pinList[cEdge._t]._y;
+            _batch._cost[i] = (query._cEdge == query._dEdge)? 0: _edgeList[query._dEdge]._cost;
+        }
+        count[t] = computeGain(_batch, begin, end, &_gainId[begin], &gain[begin]);
+        for (size_t i = 0; i < count[t]; ++i) {
+            _queryList[_gainId[begin + i]]._gain = gain[begin + i];
+        }
+    });
 
+    size_t num = count[0];
+    for (size_t t = 1; t < chunkNum; ++t) {
+        size_t begin = queryNum * t / chunkNum;
+        copy(_gainId.begin() + begin, _gainId.begin() + begin + count[t], _gainId.begin() + num);
+        num += count[t];
+    }
+    _gainId.resize(num);
     return;
 }
+
+// coordinate widths picked by getCoordWidth()
+template class MergeTree<int16_t>;
+template class MergeTree<int32_t>;
+template class MergeTree<int64_t>;
@@ -9,69 +9,100 @@
 
 #include <vector>
 #include "module.h"
+#include "gainKernel.h"
+#include "arena.h"
 using namespace std;
 
+template <class Coord> class MergeTree;
+
 class Node
 {
-    friend class MergeTree;
+    template <class Coord> friend class MergeTree;
 
 public:
     Node()  {}
-    Node(const Edge& edge, size_t left, size_t right, int gain = 0) :
+    Node(size_t edge, size_t left, size_t right, int gain = 0) :
         _edge(edge), _left(left), _right(right), _gain(gain) {}
     ~Node() {}
 
 private:
-    Edge        _edge;
-    size_t      _left;
-    size_t      _right;
+    Index       _edge;      // index into the edge list
+    Index       _left;
+    Index       _right;
     int         _gain;
 };
 
+template <class Coord>
 class MergeTree
 {
 public:
     // constructor and destructor
     // MergeTree() {}
-    MergeTree(const vector<Pin>& pinList);
+    MergeTree(const vector<Pin<Coord> >& pinList, const vector<Edge<Coord> >& edgeList,
+              Arena& arena);
     ~MergeTree() {}
 
     // disjoint set operations
     void makeSet(size_t n);
     void unionSet(size_t x, size_t y, size_t t);
-    bool sameSet(size_t x, size_t y);
     size_t findSet(size_t x);
 
     // merging tree operations
-    void addEdge(const Edge& edge);
+    void addEdge(size_t edge);
+    void buildPostOrder();
     size_t findLca(size_t x);
+    size_t findLcaSet(size_t x);
+    void unionLcaSet(size_t x, size_t y);
 
     // query operations
-    void addQuery(size_t x, size_t y, const Edge& edge);
-    void answerQuery();
-    void answerQueryRec(size_t idx);
-    void getQueryList(vector<Query>& queryList) const;
+    void reserveQuery(size_t queryNum);
+    void addQuery(size_t x, size_t y, size_t edge);
+    void answerQuery(size_t threadNum = 1);
+    void getQueryList(vector<Query<Coord> >& queryList, size_t threadNum = 1) const;
 
 private:
-    const vector<Pin>   _pinList;
+    const vector<Pin<Coord> >&  _pinList;
+    const vector<Edge<Coord> >& _edgeList;
+    Arena&                      _arena;     // scratch memory of the net
 
     // for spanning tree
-    vector<size_t>      _par;           // record the parent of each node
-    vector<size_t>      _rank;          // record the rank of each node
+    vector<Index>       _par;           // record the parent of each node
+    vector<Index>       _rank;          // record the rank of each node
 
     // for binary merging tree
     size_t              _mergeCount;
     vector<Node>        _mergeTree;     // binary merging tree
-    vector<size_t>      _mergePar;      // record the parent of each node on tree
-    vector<size_t>      _mergeRoot;     // record tree roots
+    vector<Index>       _mergePar;      // record the parent of each node on tree
+    vector<Index>       _mergeRoot;     // record tree roots
+
+    // binary merging tree laid out in post-order
+    vector<Index>       _postOrder;     // node at each position
+    vector<Index>       _postPos;       // position of each node
+    vector<Index>       _postPar;       // position of the parent of each position
+
+    // for offline lca (Tarjan), indexed by post-order position
+    vector<Index>       _lcaPar;        // disjoint-set parent
+    vector<Index>       _lcaRank;       // disjoint-set rank
+    vector<Index>       _ancestor;      // ancestor of each disjoint set
+
+    // subtrees answered in parallel, see answerQueryParallel()
+    vector<Index>       _postTask;      // task of each position, or NO_TASK
+    vector<Index>       _taskLo;        // first position of each task
+    vector<Index>       _taskHi;        // last position (root) of each task
 
-    // for query
-    vector<Query>           _queryList;
-    vector<vector<size_t> > _queryId;
+    // for query; the queries of pin p are _queryId[_queryStart[p],
+    // _queryStart[p+1]), see buildQueryIndex()
+    ArenaVector<Query<Coord> >  _queryList;
+    ArenaVector<size_t>     _queryStart;
+    ArenaVector<Index>      _queryId;
+    QueryBatch<Coord>       _batch;     // answered queries, see computeQueryGain()
+    vector<Index>           _gainId;    // queries with positive gain, in order
 
     // private member functions
-    bool sameEdge(const Edge& e1, const Edge& e2);
-    void getQueryGain(Query& query, const Edge& cEdge, const Edge& dEdge);
+    void buildQueryIndex();
+    void answerRange(size_t lo, size_t hi, bool local);
+    void answerQueryParallel(size_t threadNum);
+    void computeQueryGain(size_t threadNum);
 };
 
 #endif  // MERGETREE_H
@@ -7,73 +7,103 @@
 #ifndef MODULE_H
 #define MODULE_H
 
+#include <string>
+#include <cstdint>
 using namespace std;
 
+// non-owning view of a name inside the input buffer
+class StrView
+{
+public:
+    StrView() : _str(0), _len(0) {}
+    StrView(const char* str, size_t len) :
+        _str(str), _len(len) {}
+    ~StrView() {}
+
+    string str() const { return string(_str, _len); }
+
+    // data members
+    const char* _str;       // first character
+    size_t      _len;       // length
+};
+
+// Pin ids and edge indices are 32-bit; define ROUTER_WIDE_INDEX for nets
+// with more than 2^32 - 1 pins or edges.
+#ifdef ROUTER_WIDE_INDEX
+typedef size_t Index;
+#else
+typedef uint32_t Index;
+#endif
+
+// Coordinates, edge costs and gains share one type: the narrowest of
+// int16_t, int32_t and int64_t that holds every |x| + |y| and the Manhattan
+// distance across the chip boundary (see getCoordWidth()).
+
+// The id of a pin is its position in the pin list; names are kept apart
+// so that the pin list holds coordinates only.
+template <class Coord>
 class Pin
 {
 public:
     Pin() {}
-    Pin(int x, int y, size_t id, string name = "") :
-        _x(x), _y(y), _id(id), _name(name) {}
+    Pin(Coord x, Coord y) :
+        _x(x), _y(y) {}
     ~Pin() {}
 
     // data members
-    int         _x;         // x-coordinate of the pin
-    int         _y;         // y-coordinate of the pin
-    size_t      _id;        // id of the pin
-    string      _name;      // name of the pin
+    Coord       _x;         // x-coordinate of the pin
+    Coord       _y;         // y-coordinate of the pin
 };
 
+template <class Coord>
 class Edge
 {
 public:
     Edge() {}
-    Edge(size_t s, size_t t, int cost) :
+    Edge(size_t s, size_t t, Coord cost) :
         _s(s), _t(t), _cost(cost) {}
     ~Edge() {}
 
     // data members
-    int         _cost;      // cost of the edge
-    size_t      _s;         // source
-    size_t      _t;         // sink
+    Index       _s;         // source
+    Index       _t;         // sink
+    Coord       _cost;      // cost of the edge
 };
 
-class Query
+// A routed wire in the width-independent interface (see
+// RouterBase::getWires()): an H-line if _y1 == _y2, a V-line otherwise.
+class Wire
 {
 public:
-    Query(size_t w, size_t u, const Edge& edge) :
-        _w(w), _u(u), _cEdge(edge), _c(0) {}
-    ~Query() {}
+    Wire() {}
+    Wire(long x1, long y1, long x2, long y2) :
+        _x1(x1), _y1(y1), _x2(x2), _y2(y2) {}
+    ~Wire() {}
 
     // data members
-    size_t      _w;         // neighbor pin of either s or t of the cEdge
-    size_t      _u;         // either s or t
-    size_t      _c;         // counter for dfs
-    Edge        _cEdge;     // the edge that w is trying to connect to
-    Edge        _dEdge;     // the longest edge on the created cycle
-    int         _gain;      // gain from deleting edge
+    long        _x1;        // x-coordinate of one end
+    long        _y1;        // y-coordinate of one end
+    long        _x2;        // x-coordinate of the other end
+    long        _y2;        // y-coordinate of the other end
 };
 
-// sorting
-struct SortEdgeCost
-{
-    bool operator () (Edge& e1, Edge& e2) {
-        return (e1._cost < e2._cost);
-    }
-};
-
-struct SortQueryGain
+// Edges of a query are indices into the (sorted) edge list.
+template <class Coord>
+class Query
 {
-    bool operator () (Query& q1, Query& q2) {
-        return (q1._gain > q2._gain);
-    }
-};
+public:
+    Query() {}
+    Query(size_t w, size_t u, size_t edge) :
+        _w(w), _u(u), _cEdge(edge), _dEdge(edge), _gain(0), _c(0) {}
+    ~Query() {}
 
-struct EdgeCmp
-{
-    bool operator () (const Edge& e1, const Edge& e2) const {
-        return (e1._t < e2._t || (e1._t == e2._t && e1._s < e2._s));
-    }
+    // data members
+    Index       _w;         // neighbor pin of either s or t of the cEdge
+    Index       _u;         // either s or t
+    Index       _cEdge;     // the edge that w is trying to connect to
+    Index       _dEdge;     // the longest edge on the created cycle
+    Coord       _gain;      // gain from deleting edge
+    uint8_t     _c;         // counter for dfs
 };
 
 #endif // MODULE_H
@@ -0,0 +1,97 @@
+/****************************************************************************
+  FileName  [ mst.cpp ]
+  Synopsis  [ Implementation of the parallel Filter-Kruskal. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.25 ]
+****************************************************************************/
+#include <numeric>
+#include <algorithm>
+#include "mst.h"
+#include "parallel.h"
+using namespace std;
+
+template <class Coord>
+void FilterKruskal<Coord>::genTree(size_t pinNum, const vector<Edge<Coord> >& edgeList,
+                                   vector<Index>& treeEdge)
+{
+    _par.resize(pinNum);
+    _rank.assign(pinNum, 0);
+    iota(_par.begin(), _par.end(), 0);
+    treeEdge.clear();
+    if (pinNum < 2) return;
+    treeEdge.reserve(pinNum - 1);
+
+    vector<Index> active(edgeList.size());
+    iota(active.begin(), active.end(), 0);
+    vector<vector<Index> > kept(_threadNum);
+    size_t blockSize = max(pinNum, (size_t)1024);
+
+    while (!active.empty() && treeEdge.size() < pinNum - 1) {
+        // Kruskal on the lightest block
+        size_t block = min(blockSize, active.size());
+        for (size_t i = 0; i < block; ++i) {
+            const Edge<Coord>& edge = edgeList[active[i]];
+            size_t x = findSet(edge._s);
+            size_t y = findSet(edge._t);
+            if (x == y) continue;
+            treeEdge.push_back(active[i]);
+            if (_rank[x] < _rank[y]) {
+                _par[x] = y;
+            }
+            else if (_rank[x] > _rank[y]) {
+                _par[y] = x;
+            }
+            else {
+                _par[x] = y;
+                _rank[y] += 1;
+            }
+        }
+        if (block == active.size() || treeEdge.size() == pinNum - 1) break;
+
+        // filter the rest; the disjoint set is only read here
+        size_t restNum = active.size() - block;
+        size_t threadNum = (restNum < (1 << 14))? 1: min(_threadNum, restNum >> 13);
+        parallelRun(threadNum, threadNum, [&](size_t t) {
+            kept[t].clear();
+            for (size_t i = block + restNum * t / threadNum,
+                 end = block + restNum * (t + 1) / threadNum; i < end; ++i) {
+                const Edge<Coord>& edge = edgeList[active[i]];
+                if (findRoot(edge._s) != findRoot(edge._t)) {
+                    kept[t].push_back(active[i]);
+                }
+            }
+        });
+        active.clear();
+        for (size_t t = 0; t < threadNum; ++t) {
+            active.insert(active.end(), kept[t].begin(), kept[t].end());
+        }
+    }
+    return;
+}
+
+// with path compression
+template <class Coord>
+size_t FilterKruskal<Coord>::findSet(size_t x)
+{
+    size_t root = x;
+    while (_par[root] != root) root = _par[root];
+    while (_par[x] != root) {
+        size_t next = _par[x];
+        _par[x] = root;
+        x = next;
+    }
+    return root;
+}
+
+// read-only, safe to call from several threads at once
+template <class Coord>
+size_t FilterKruskal<Coord>::findRoot(size_t x) const
+{
+    while (_par[x] != x) x = _par[x];
+    return x;
+}
+
+// coordinate widths picked by getCoordWidth()
+template class FilterKruskal<int16_t>;
+template class FilterKruskal<int32_t>;
+template class FilterKruskal<int64_t>;
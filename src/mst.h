@@ -0,0 +1,42 @@
+/****************************************************************************
+  FileName  [ mst.h ]
+  Synopsis  [ Define the parallel Filter-Kruskal minimum spanning tree. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.25 ]
+****************************************************************************/
+#ifndef MST_H
+#define MST_H
+
+#include <vector>
+#include "module.h"
+using namespace std;
+
+// Filter-Kruskal over an edge list that is already sorted by cost. Each
+// round runs Kruskal on the lightest remaining block and then drops, in
+// parallel, every heavier edge whose ends are already connected. The tree
+// edges come out in the order sequential Kruskal accepts them, which is
+// the merge order MergeTree::addEdge() expects.
+template <class Coord>
+class FilterKruskal
+{
+public:
+    // constructor and destructor
+    FilterKruskal(size_t threadNum = 1) :
+        _threadNum(threadNum) {}
+    ~FilterKruskal() {}
+
+    // modify methods
+    void genTree(size_t pinNum, const vector<Edge<Coord> >& edgeList,
+                 vector<Index>& treeEdge);
+
+private:
+    size_t          _threadNum;     // threads for the filter step
+    vector<Index>   _par;           // disjoint-set parent
+    vector<Index>   _rank;          // disjoint-set rank
+
+    // private member functions
+    size_t findSet(size_t x);
+    size_t findRoot(size_t x) const;
+};
+
+#endif // MST_H
@@ -0,0 +1,83 @@
+/****************************************************************************
+  FileName  [ netRouter.cpp ]
+  Synopsis  [ Implementation of the in-memory interface of the router library. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.29 ]
+****************************************************************************/
+#include <algorithm>
+#include <cassert>
+#include "netRouter.h"
+using namespace std;
+
+NetRouter::NetRouter(const RouterOption& option) :
+    _option(option), _last(0)
+{
+    for (size_t i = 0; i < 3; ++i) {
+        _router[i] = 0;
+    }
+}
+
+NetRouter::~NetRouter()
+{
+    for (size_t i = 0; i < 3; ++i) {
+        delete _router[i];
+    }
+}
+
+void NetRouter::setOption(const RouterOption& option)
+{
+    _option = option;
+    for (size_t i = 0; i < 3; ++i) {
+        if (_router[i] != 0) _router[i]->setOption(option);
+    }
+    return;
+}
+
+// router for the given coordinate width, owned by this object
+RouterBase* NetRouter::getRouter(size_t width)
+{
+    RouterBase*& router = _router[(width == 16)? 0: (width == 32)? 1: 2];
+    if (router == 0) {
+        router = createRouter(width);
+        router->setOption(_option);
+    }
+    _last = router;
+    return router;
+}
+
+// Route the net of pins (x[i], y[i]). The arrays are not kept.
+void NetRouter::route(const long* x, const long* y, size_t pinNum)
+{
+    long xmin = 0, ymin = 0, xmax = 0, ymax = 0;
+    if (pinNum > 0) {
+        xmin = *min_element(x, x + pinNum);
+        xmax = *max_element(x, x + pinNum);
+        ymin = *min_element(y, y + pinNum);
+        ymax = *max_element(y, y + pinNum);
+    }
+    RouterBase* router = this->getRouter(getCoordWidth(xmin, ymin, xmax, ymax));
+    router->setInput(x, y, pinNum);
+    router->route();
+    return;
+}
+
+// drop the nets, keeping the capacity of every router
+void NetRouter::reset()
+{
+    for (size_t i = 0; i < 3; ++i) {
+        if (_router[i] != 0) _router[i]->reset();
+    }
+    _last = 0;
+    return;
+}
+
+long NetRouter::getWireLength() const
+{
+    return (_last == 0)? 0: _last->getWireLength();
+}
+
+// See RouterBase::getWires().
+size_t NetRouter::getWires(Wire* wire, size_t capacity) const
+{
+    return (_last == 0)? 0: _last->getWires(wire, capacity);
+}
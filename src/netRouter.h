@@ -0,0 +1,48 @@
+/****************************************************************************
+  FileName  [ netRouter.h ]
+  Synopsis  [ Define the in-memory interface of the router library. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.29 ]
+****************************************************************************/
+#ifndef NETROUTER_H
+#define NETROUTER_H
+
+#include <cstddef>
+#include "router.h"
+using namespace std;
+
+// Routes nets one after another without files. Pins come in as coordinate
+// arrays and the wires go out to a buffer of the caller. One router per
+// coordinate width is created on first use and kept, so the lists it
+// grew for one net are reused by the next.
+class NetRouter
+{
+public:
+    // constructor and destructor
+    NetRouter(const RouterOption& option = RouterOption());
+    ~NetRouter();
+
+    // basic access methods
+    const RouterOption& getOption() const   { return _option; }
+    void setOption(const RouterOption& option);
+    RouterBase* getRouter(size_t width);
+
+    // modify methods
+    void route(const long* x, const long* y, size_t pinNum);
+    void reset();
+
+    // query methods, about the last routed net
+    long getWireLength() const;
+    size_t getWires(Wire* wire, size_t capacity) const;
+
+private:
+    RouterOption    _option;        // options of every router
+    RouterBase*     _router[3];     // 16-, 32- and 64-bit routers
+    RouterBase*     _last;          // router of the last net
+
+    // non-copyable
+    NetRouter(const NetRouter&);
+    NetRouter& operator = (const NetRouter&);
+};
+
+#endif // NETROUTER_H
@@ -0,0 +1,132 @@
+/****************************************************************************
+  FileName  [ parallel.h ]
+  Synopsis  [ Define the thread helpers shared by the routing phases. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.23 ]
+****************************************************************************/
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+using namespace std;
+
+// number of threads to use when the caller asks for 0 (= all cores)
+inline size_t getThreadNum(size_t threadNum)
+{
+    if (threadNum == 0) threadNum = thread::hardware_concurrency();
+    return (threadNum == 0)? 1: threadNum;
+}
+
+// run task(i) for every i in [0, taskNum) on at most threadNum threads,
+// each taking the next task from a shared counter
+template <class Task>
+void parallelRun(size_t taskNum, size_t threadNum, Task task)
+{
+    size_t workerNum = min(taskNum, threadNum);
+    if (workerNum <= 1) {
+        for (size_t i = 0; i < taskNum; ++i) task(i);
+        return;
+    }
+    atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < taskNum; i = next++) task(i);
+    };
+    vector<thread> workers;
+    for (size_t i = 1; i < workerNum; ++i) {
+        workers.push_back(thread(work));
+    }
+    work();
+    for (size_t i = 0, end = workers.size(); i < end; ++i) {
+        workers[i].join();
+    }
+    return;
+}
+
+// run func(begin, end) over [0, n) split into threadNum equal chunks
+template <class Func>
+void parallelFor(size_t n, size_t threadNum, Func func)
+{
+    threadNum = max((size_t)1, min(threadNum, n));
+    parallelRun(threadNum, threadNum, [&](size_t i) {
+        func(n * i / threadNum, n * (i + 1) / threadNum);
+    });
+    return;
+}
+
+// Run task(i) for every i in [0, taskNum) on threadNum threads. Tasks are
+// dealt round-robin into per-thread deques; a thread pops from the back of
+// its own deque and, once that is empty, steals from the front of others.
+template <class Task>
+void workStealingRun(size_t taskNum, size_t threadNum, Task task)
+{
+    threadNum = max((size_t)1, min(threadNum, taskNum));
+    vector<deque<size_t> > queue(threadNum);
+    vector<mutex> lock(threadNum);
+    for (size_t i = 0; i < taskNum; ++i) {
+        queue[i % threadNum].push_back(i);
+    }
+
+    parallelRun(threadNum, threadNum, [&](size_t t) {
+        for (;;) {
+            size_t next = taskNum;
+            {
+                lock_guard<mutex> guard(lock[t]);
+                if (!queue[t].empty()) {
+                    next = queue[t].back();
+                    queue[t].pop_back();
+                }
+            }
+            for (size_t k = 1; next == taskNum && k < threadNum; ++k) {
+                size_t victim = (t + k) % threadNum;
+                lock_guard<mutex> guard(lock[victim]);
+                if (!queue[victim].empty()) {
+                    next = queue[victim].front();
+                    queue[victim].pop_front();
+                }
+            }
+            if (next == taskNum) return;
+            task(next);
+        }
+    });
+    return;
+}
+
+// Stable merge sort: chunks are sorted concurrently and merged pairwise.
+// The result does not depend on the number of threads.
+template <class Iter, class Cmp>
+void parallelSort(Iter begin, Iter end, Cmp cmp, size_t threadNum)
+{
+    size_t n = end - begin;
+    if (threadNum <= 1 || n < 4096) {
+        stable_sort(begin, end, cmp);
+        return;
+    }
+
+    size_t chunkNum = min(threadNum, n / 1024);
+    vector<size_t> bound(chunkNum + 1);
+    for (size_t i = 0; i <= chunkNum; ++i) bound[i] = n * i / chunkNum;
+
+    parallelRun(chunkNum, threadNum, [&](size_t i) {
+        stable_sort(begin + bound[i], begin + bound[i+1], cmp);
+    });
+
+    for (size_t width = 1; width < chunkNum; width *= 2) {
+        size_t mergeNum = (chunkNum + 2 * width - 1) / (2 * width);
+        parallelRun(mergeNum, threadNum, [&](size_t i) {
+            size_t lo = 2 * width * i;
+            size_t mid = min(lo + width, chunkNum);
+            size_t hi = min(lo + 2 * width, chunkNum);
+            if (mid < hi) {
+                inplace_merge(begin + bound[lo], begin + bound[mid], begin + bound[hi], cmp);
+            }
+        });
+    }
+    return;
+}
+
+#endif // PARALLEL_H
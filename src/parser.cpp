@@ -0,0 +1,73 @@
+/****************************************************************************
+  FileName  [ parser.cpp ]
+  Synopsis  [ Implementation of the memory-mapped input file. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.21 ]
+****************************************************************************/
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "parser.h"
+using namespace std;
+
+bool MappedFile::open(const char* fileName)
+{
+    this->close();
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // regular file: map it read-only
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            _data = (char*)data;
+            _size = st.st_size;
+            _mapped = true;
+            ::close(fd);
+            return true;
+        }
+    }
+
+    // pipes and the like: read everything into one buffer
+    size_t cap = 1 << 16;
+    _data = (char*)malloc(cap);
+    ssize_t n = 0;
+    while (_data && (n = read(fd, _data + _size, cap - _size)) > 0) {
+        _size += n;
+        if (_size == cap) {
+            cap *= 2;
+            char* data = (char*)realloc(_data, cap);
+            if (data == 0) free(_data);
+            _data = data;
+        }
+    }
+    ::close(fd);
+    if (_data == 0 || n < 0) {
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_mapped) {
+        munmap(_data, _size);
+    }
+    else {
+        free(_data);
+    }
+    _data = 0;
+    _size = 0;
+    _mapped = false;
+    return;
+}
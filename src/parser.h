@@ -0,0 +1,130 @@
+/****************************************************************************
+  FileName  [ parser.h ]
+  Synopsis  [ Define the memory-mapped input file and the token scanner. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.21 ]
+****************************************************************************/
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <cstddef>
+#include <cstring>
+#include <cassert>
+#include "module.h"
+using namespace std;
+
+class MappedFile
+{
+public:
+    // constructor and destructor
+    MappedFile() : _data(0), _size(0), _mapped(false) {}
+    ~MappedFile() { this->close(); }
+
+    // basic access methods
+    const char* begin() const   { return _data; }
+    const char* end() const     { return _data + _size; }
+    size_t size() const         { return _size; }
+
+    // modify methods
+    bool open(const char* fileName);
+    void close();
+
+private:
+    char*       _data;      // start of the mapped buffer
+    size_t      _size;      // size of the file in bytes
+    bool        _mapped;    // whether _data comes from mmap
+
+    // non-copyable
+    MappedFile(const MappedFile&);
+    MappedFile& operator = (const MappedFile&);
+};
+
+// Scans the input grammar in place; no token is copied.
+class Scanner
+{
+public:
+    // constructor and destructor
+    Scanner(const char* begin, const char* end) :
+        _cur(begin), _end(end) {}
+    ~Scanner() {}
+
+    // basic access methods
+    const char* getPos() const  { return _cur; }
+    bool eof() {
+        this->skipSpace();
+        return (_cur == _end);
+    }
+
+    // skip blanks and line breaks
+    void skipSpace() {
+        while (_cur != _end && (unsigned char)*_cur <= ' ') ++_cur;
+    }
+
+    // consume the given keyword or punctuation, return false if absent
+    bool match(const char* word) {
+        this->skipSpace();
+        size_t len = strlen(word);
+        if ((size_t)(_end - _cur) < len || memcmp(_cur, word, len) != 0)
+            return false;
+        _cur += len;
+        return true;
+    }
+
+    // next white-space delimited token as a view into the buffer
+    StrView getToken() {
+        this->skipSpace();
+        const char* begin = _cur;
+        while (_cur != _end && (unsigned char)*_cur > ' ') ++_cur;
+        return StrView(begin, _cur - begin);
+    }
+
+    // hand-written signed decimal scanner
+    long getInt() {
+        this->skipSpace();
+        bool neg = false;
+        if (_cur != _end && (*_cur == '-' || *_cur == '+')) {
+            neg = (*_cur == '-');
+            ++_cur;
+        }
+        assert(_cur != _end && (unsigned)(*_cur - '0') < 10);
+        long val = 0;
+        while (_cur != _end && (unsigned)(*_cur - '0') < 10) {
+            val = val * 10 + (*_cur - '0');
+            ++_cur;
+        }
+        return (neg)? -val: val;
+    }
+
+    // "(x,y)", both values must fit in T
+    template <class T>
+    void getPoint(T& x, T& y) {
+        bool ok = this->match("(");
+        long vx = this->getInt();
+        ok = ok && this->match(",");
+        long vy = this->getInt();
+        ok = ok && this->match(")");
+        x = vx;
+        y = vy;
+        assert(ok && x == vx && y == vy);
+        (void)ok;
+    }
+
+    // find the start of the next line beginning with the given word
+    const char* findLine(const char* word) const {
+        size_t len = strlen(word);
+        for (const char* p = _cur; p != _end; ++p) {
+            if ((p == _cur || *(p-1) == '\n') && (size_t)(_end - p) >= len &&
+                memcmp(p, word, len) == 0)
+                return p;
+            p = (const char*)memchr(p, '\n', _end - p);
+            if (p == 0) break;
+        }
+        return _end;
+    }
+
+private:
+    const char* _cur;       // current position
+    const char* _end;       // end of buffer
+};
+
+#endif // PARSER_H
@@ -0,0 +1,71 @@
+/****************************************************************************
+  FileName  [ radixSort.h ]
+  Synopsis  [ Define the stable LSD radix sort for edge costs and gains. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.24 ]
+****************************************************************************/
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <vector>
+#include <algorithm>
+#include "parallel.h"
+using namespace std;
+
+// Stable sort of data by the unsigned key key(x), 8 bits per pass. Only as
+// many passes as the largest key needs are run. Each thread counts and
+// scatters its own contiguous chunk; the chunk offsets are laid out in
+// thread order, so the result is the same for any number of threads.
+template <class T, class Key>
+void radixSort(vector<T>& data, Key key, size_t threadNum = 1)
+{
+    size_t n = data.size();
+    if (n < 256) {
+        stable_sort(data.begin(), data.end(), [&](const T& a, const T& b) {
+            return key(a) < key(b);
+        });
+        return;
+    }
+    threadNum = (n < (1 << 16))? 1: min(threadNum, n >> 15);
+    threadNum = max(threadNum, (size_t)1);
+
+    unsigned long long maxKey = 0;
+    for (size_t i = 0; i < n; ++i) {
+        maxKey = max(maxKey, (unsigned long long)key(data[i]));
+    }
+
+    vector<T> buf(n);
+    vector<size_t> count(threadNum * 256);
+    for (size_t shift = 0; shift < 64 && (maxKey >> shift) != 0; shift += 8) {
+        // histogram per thread
+        fill(count.begin(), count.end(), 0);
+        parallelRun(threadNum, threadNum, [&](size_t t) {
+            size_t* cnt = &count[t * 256];
+            for (size_t i = n * t / threadNum, end = n * (t + 1) / threadNum; i < end; ++i) {
+                ++cnt[(key(data[i]) >> shift) & 0xff];
+            }
+        });
+
+        // exclusive prefix sum, digit-major then thread
+        size_t sum = 0;
+        for (size_t d = 0; d < 256; ++d) {
+            for (size_t t = 0; t < threadNum; ++t) {
+                size_t c = count[t * 256 + d];
+                count[t * 256 + d] = sum;
+                sum += c;
+            }
+        }
+
+        // scatter
+        parallelRun(threadNum, threadNum, [&](size_t t) {
+            size_t* pos = &count[t * 256];
+            for (size_t i = n * t / threadNum, end = n * (t + 1) / threadNum; i < end; ++i) {
+                buf[pos[(key(data[i]) >> shift) & 0xff]++] = data[i];
+            }
+        });
+        data.swap(buf);
+    }
+    return;
+}
+
+#endif // RADIXSORT_H
@@ -8,41 +8,65 @@
 #include <iomanip>
 #include <string>
 #include <algorithm>
+#include <numeric>
+#include <cstdlib>
 #include <cassert>
-#include <set>
 #include <map>
-#include <boost/pending/disjoint_sets.hpp>
+#include <limits>
+#include <type_traits>
+#include <atomic>
+#include <cmath>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include "router.h"
 #include "mergeTree.h"
+#include "parser.h"
+#include "parallel.h"
+#include "radixSort.h"
+#include "mst.h"
+#include "arena.h"
 using namespace std;
 using namespace cv;
 
-// using DisjointSet = boost::disjoint_sets<size_t*, size_t*>;
+template <class Coord>
+using rev_multimap = multimap<Coord, Index, greater<Coord>,
+                              ArenaAllocator<pair<const Coord, Index> > >;
+template <class Coord>
+using fwd_multimap = multimap<Coord, Index, less<Coord>,
+                              ArenaAllocator<pair<const Coord, Index> > >;
 
-auto larger = [](int x, int y) { return x > y; };
-using rev_multimap = multimap<int, int, decltype(larger)>;
-
-// for parsing usage
-void getCoordinate(int& x, int& y, string& str)
+// get Manhattan distance
+template <class Coord>
+Coord getDistance(const Pin<Coord>& p1, const Pin<Coord>& p2)
 {
-    size_t pos = str.find_first_of(',');
-    size_t last = str.find_last_of(')');
-    x = stoi(str.substr(1, pos-1));
-    y = stoi(str.substr(pos+1, last-pos-1));
-    return;
+    return (abs(p1._x - p2._x) + abs(p1._y - p2._y));
 }
 
-// get Manhattan distance
-int getDistance(const Pin& p1, const Pin& p2)
+// distance of (x, y) along the Hilbert curve filling a 2^order square
+inline unsigned long long getHilbertKey(unsigned long long x, unsigned long long y, size_t order)
 {
-    return (abs(p1._x - p2._x) + abs(p1._y - p2._y));
+    unsigned long long n = 1ULL << order;
+    unsigned long long key = 0;
+    for (unsigned long long s = n >> 1; s > 0; s >>= 1) {
+        unsigned long long rx = ((x & s) != 0);
+        unsigned long long ry = ((y & s) != 0);
+        key += s * s * ((3 * rx) ^ ry);
+        // rotate the quadrant
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            swap(x, y);
+        }
+    }
+    return key;
 }
 
 // check in region
-bool inRegion(int r, const Pin& p1, const Pin& p2)
+template <class Coord>
+bool inRegion(int r, const Pin<Coord>& p1, const Pin<Coord>& p2)
 {
     switch(r) {
         case 1:
@@ -60,87 +84,312 @@ bool inRegion(int r, const Pin& p1, const Pin& p2)
     return false;
 }
 
-void Router::parseInput(fstream& inFile)
+// Drop the net but keep the capacity of the lists for the next one.
+template <class Coord>
+void Router<Coord>::reset()
 {
-    string str;
+    _pinList.clear();
+    _pinName.clear();
+    _dupPin.clear();
+    _edgeList.clear();
+    _treeList.clear();
+    _treeId.clear();
+    _queryList.clear();
+    _ecoSeed.clear();
+    _pinNum = _oPinNum = _uPinNum = 0;
+    this->releaseScratch();
+    return;
+}
+
+// Give the scratch memory of the net back to the arenas, noting its size.
+template <class Coord>
+void Router<Coord>::releaseScratch()
+{
+    _scratchSize = _arena.getAllocSize();
+    _arena.release();
+    for (size_t r = 0; r < 4; ++r) {
+        _scratchSize += _sweepArena[r].getAllocSize();
+        _sweepArena[r].release();
+    }
+    return;
+}
+
+// The buffer must outlive the router: pin names are views into it.
+template <class Coord>
+void Router<Coord>::parseInput(const char* begin, const char* end)
+{
+    Scanner scanner(begin, end);
+    this->reset();
+
     // read chip boundary
-    inFile >> str;
-    assert(str == "Boundary");
-    for (size_t i = 0; i < 3; ++i) {
-        inFile >> str;
-        if (i == 1) {
-            str = str.substr(0, str.length()-1);
-            getCoordinate(_xmin, _ymin, str);
+    bool ok = scanner.match("Boundary") && scanner.match("=");
+    assert(ok);
+    scanner.getPoint(_xmin, _ymin);
+    ok = scanner.match(",");
+    assert(ok);
+    scanner.getPoint(_xmax, _ymax);
+
+    // read pin number
+    ok = scanner.match("NumPins") && scanner.match("=");
+    assert(ok);
+    _pinNum = scanner.getInt();
+    _oPinNum = _pinNum;
+    _uPinNum = _pinNum;
+
+    // read pins
+    _pinList.reserve(_pinNum);
+    _pinName.reserve(_pinNum);
+    for (size_t i = 0; i < _pinNum; ++i) {
+        Coord x, y;
+        ok = scanner.match("PIN");
+        assert(ok);
+        _pinName.push_back(scanner.getToken());
+        scanner.getPoint(x, y);
+        _pinList.push_back(Pin<Coord>(x, y));
+    }
+    (void)ok;
+    return;
+}
+
+// Net given by the coordinates of its pins; the boundary is their bounding
+// box, which must fit the coordinate width (see getCoordWidth()). The pins
+// have no names, so incremental changes need parseInput().
+template <class Coord>
+void Router<Coord>::setInput(const long* x, const long* y, size_t pinNum)
+{
+    this->reset();
+    long xmin = 0, ymin = 0, xmax = 0, ymax = 0;
+    if (pinNum > 0) {
+        xmin = *min_element(x, x + pinNum);
+        xmax = *max_element(x, x + pinNum);
+        ymin = *min_element(y, y + pinNum);
+        ymax = *max_element(y, y + pinNum);
+    }
+    assert(getCoordWidth(xmin, ymin, xmax, ymax) <= 8 * sizeof(Coord));
+    _xmin = xmin;
+    _ymin = ymin;
+    _xmax = xmax;
+    _ymax = ymax;
+
+    _pinList.reserve(pinNum);
+    for (size_t i = 0; i < pinNum; ++i) {
+        _pinList.push_back(Pin<Coord>(x[i], y[i]));
+    }
+    _pinName.assign(pinNum, StrView());
+    _pinNum = _oPinNum = _uPinNum = pinNum;
+    return;
+}
+
+// Pins at the same coordinates are routed once. The first of them (in input
+// order) stays in the pin list; the others are moved behind the distinct
+// pins, and _dupPin keeps the pin each of them coincides with. Their names
+// follow the distinct names in _pinName.
+template <class Coord>
+void Router<Coord>::dedupPins()
+{
+    typedef typename make_unsigned<Coord>::type UCoord;
+    const UCoord sign = (UCoord)1 << (8 * sizeof(Coord) - 1);
+    size_t threadNum = getThreadNum(_option._threadNum);
+    size_t pinNum = _pinList.size();
+
+    // stable order of (x, y)
+    vector<Index> order(pinNum);
+    iota(order.begin(), order.end(), 0);
+    radixSort(order, [&](Index i) {
+        return (UCoord)((UCoord)_pinList[i]._y ^ sign);
+    }, threadNum);
+    radixSort(order, [&](Index i) {
+        return (UCoord)((UCoord)_pinList[i]._x ^ sign);
+    }, threadNum);
+
+    vector<Index> rep(pinNum);
+    bool dup = false;
+    for (size_t i = 0; i < pinNum; ++i) {
+        const Pin<Coord>& pin = _pinList[order[i]];
+        if (i > 0 && pin._x == _pinList[order[i - 1]]._x && pin._y == _pinList[order[i - 1]]._y) {
+            rep[order[i]] = rep[order[i - 1]];
+            dup = true;
         }
-        if (i == 2) {
-            getCoordinate(_xmax, _ymax, str);
+        else {
+            rep[order[i]] = order[i];
         }
     }
+    if (!dup) return;
 
-    // read pin number
-    inFile >> str;
-    assert(str == "NumPins");
-    for (size_t i = 0; i < 2; ++i) {
-        inFile >> str;
-        if (i == 1) {
-            _pinNum = stoi(str);
-            _oPinNum = _pinNum;
+    // distinct pins first, then the names of the duplicates
+    vector<Index> newId(pinNum);
+    vector<StrView> dupName;
+    size_t num = 0;
+    for (size_t i = 0; i < pinNum; ++i) {
+        if (rep[i] == i) {
+            newId[i] = num;
+            _pinList[num] = _pinList[i];
+            _pinName[num] = _pinName[i];
+            ++num;
+        }
+        else {
+            _dupPin.push_back(newId[rep[i]]);
+            dupName.push_back(_pinName[i]);
         }
     }
+    copy(dupName.begin(), dupName.end(), _pinName.begin() + num);
+    _pinList.resize(num);
+    _pinNum = num;
+    _uPinNum = num;
+    return;
+}
 
-    // read pins
-    for (size_t i = 0; i < _pinNum; ++i) {
-        string name;
-        int x, y;
-        for (size_t j = 0; j < 3; ++j) {
-            inFile >> str;
-            if (j == 0)
-                assert(str == "PIN");
-            else if (j == 1)
-                name = str;
-            else
-                getCoordinate(x, y, str);
+// Renumber the distinct pins in the order they are met along a Hilbert
+// curve over their bounding square, so that pins close on the chip are
+// close in the pin list. Names, when the router has them, move with their
+// pins.
+template <class Coord>
+void Router<Coord>::reorderPins()
+{
+    typedef unsigned long long Key;
+    size_t threadNum = getThreadNum(_option._threadNum);
+    size_t pinNum = _pinList.size();
+    if (pinNum < 2) return;
+
+    Coord minX = _pinList[0]._x, maxX = minX;
+    Coord minY = _pinList[0]._y, maxY = minY;
+    for (size_t i = 1; i < pinNum; ++i) {
+        minX = min(minX, _pinList[i]._x);
+        maxX = max(maxX, _pinList[i]._x);
+        minY = min(minY, _pinList[i]._y);
+        maxY = max(maxY, _pinList[i]._y);
+    }
+    // at most 32 bits per axis, so that a key fits in 64 bits
+    Key span = max((Key)((long)maxX - (long)minX), (Key)((long)maxY - (long)minY));
+    size_t order = 1, shift = 0;
+    while (order < 64 && (span >> order) != 0) ++order;
+    if (order > 32) {
+        shift = order - 32;
+        order = 32;
+    }
+
+    vector<Key> key(pinNum);
+    parallelFor(pinNum, (pinNum < (1 << 16))? 1: threadNum, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            key[i] = getHilbertKey((Key)((long)_pinList[i]._x - (long)minX) >> shift,
+                                   (Key)((long)_pinList[i]._y - (long)minY) >> shift, order);
         }
-        _pinList.push_back(Pin(x, y, i, name));
+    });
+    vector<Index> pinOrder(pinNum);
+    iota(pinOrder.begin(), pinOrder.end(), 0);
+    radixSort(pinOrder, [&](Index i) {
+        return key[i];
+    }, threadNum);
+
+    vector<Pin<Coord> > pinList(pinNum);
+    vector<StrView> pinName(_pinName);
+    bool named = (_pinName.size() >= pinNum);
+    vector<Index> newId(pinNum);
+    for (size_t i = 0; i < pinNum; ++i) {
+        pinList[i] = _pinList[pinOrder[i]];
+        if (named) _pinName[i] = pinName[pinOrder[i]];
+        newId[pinOrder[i]] = i;
+    }
+    _pinList.swap(pinList);
+    for (size_t i = 0, end = _dupPin.size(); i < end; ++i) {
+        _dupPin[i] = newId[_dupPin[i]];
     }
     return;
 }
 
-void Router::genSpanningGraph()
+// Nets of at most three pins, and nets on one line, have closed-form
+// minimum trees. Three pins meet at their median point; collinear pins are
+// chained in order along the line. Returns false for other nets.
+template <class Coord>
+bool Router<Coord>::routeSmall()
 {
-    // active set
-    rev_multimap actSet1(larger);
-    rev_multimap actSet2(larger);
-    multimap<int, int> actSet3;
-    rev_multimap actSet4(larger);
+    _treeList.clear();
+    if (_pinNum <= 1) return true;
+    if (_pinNum == 2) {
+        _treeList.push_back(Edge<Coord>(0, 1, getDistance(_pinList[0], _pinList[1])));
+        return true;
+    }
+    if (_pinNum == 3) {
+        Coord x[3], y[3];
+        for (size_t i = 0; i < 3; ++i) {
+            x[i] = _pinList[i]._x;
+            y[i] = _pinList[i]._y;
+        }
+        sort(x, x + 3);
+        sort(y, y + 3);
+        Pin<Coord> median(x[1], y[1]);
+        size_t center = 3;
+        for (size_t i = 0; i < 3; ++i) {
+            if (_pinList[i]._x == median._x && _pinList[i]._y == median._y) center = i;
+        }
+        if (center == 3) {
+            _pinList.push_back(median);
+            _pinNum += 1;
+        }
+        for (size_t i = 0; i < 3; ++i) {
+            if (i == center) continue;
+            _treeList.push_back(Edge<Coord>(i, center, getDistance(_pinList[i], _pinList[center])));
+        }
+        return true;
+    }
 
-    vector<size_t> pinIds;
-    for (size_t i = 0, end = _pinList.size(); i < end; ++i) {
-        pinIds.push_back(i);
+    bool sameX = true, sameY = true;
+    for (size_t i = 1; i < _pinNum && (sameX || sameY); ++i) {
+        sameX = sameX && (_pinList[i]._x == _pinList[0]._x);
+        sameY = sameY && (_pinList[i]._y == _pinList[0]._y);
     }
+    if (!sameX && !sameY) return false;
 
-    // Sort by x + y
-    sort(pinIds.begin(), pinIds.end(),
-         [&](int id1, int id2) {
-         const Pin& pin1 = _pinList[id1];
-         const Pin& pin2 = _pinList[id2];
-         return (pin1._x + pin1._y < pin2._x + pin2._y);
+    vector<Index> order(_pinNum);
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](Index a, Index b) {
+        return (sameX)? (_pinList[a]._y < _pinList[b]._y): (_pinList[a]._x < _pinList[b]._x);
     });
+    _treeList.reserve(_pinNum - 1);
+    for (size_t i = 1; i < _pinNum; ++i) {
+        const Pin<Coord>& s = _pinList[order[i - 1]];
+        const Pin<Coord>& t = _pinList[order[i]];
+        _treeList.push_back(Edge<Coord>(order[i - 1], order[i], getDistance(s, t)));
+    }
+    return true;
+}
+
+template <class Coord>
+void Router<Coord>::genSpanningGraph()
+{
+    if (_option._fenwickSweep) {
+        _fenwick.genEdges(_pinList, _edgeList);
+    }
+    else {
+        this->sweepMultimap();
+    }
+    return;
+}
 
+// Sweep one region over the sorted pins. The active set is keyed by x
+// (useX) or by y, and the scan starts after the key if upper is set.
+// Edges found at the i-th pin are edgeList[offset[i], offset[i+1]).
+template <class Coord, class ActSet>
+void sweepRegion(int r, ActSet& actSet, bool useX, bool upper,
+                 const vector<Pin<Coord> >& pinList, const ArenaVector<Index>& pinIds,
+                 ArenaVector<Edge<Coord> >& edgeList, ArenaVector<size_t>& offset)
+{
+    offset.resize(pinIds.size() + 1);
+    offset[0] = 0;
     for (size_t i = 0, end = pinIds.size(); i < end; ++i) {
         size_t current_pin_id = pinIds[i];
-        const Pin& current_pin = _pinList[current_pin_id];
-        actSet1.insert(make_pair(current_pin._x, current_pin_id));
-        actSet2.insert(make_pair(current_pin._y, current_pin_id));
+        const Pin<Coord>& current_pin = pinList[current_pin_id];
+        Coord key = (useX)? current_pin._x: current_pin._y;
+        actSet.insert(make_pair(key, current_pin_id));
 
-        // Region 1
-        for (auto it = actSet1.lower_bound(current_pin._x); it != actSet1.end();) {
-            const int pin_id = it->second;
+        auto it = (upper)? actSet.upper_bound(key): actSet.lower_bound(key);
+        while (it != actSet.end()) {
+            const size_t pin_id = it->second;
             if (pin_id != current_pin_id) {
-                const Pin& pin = _pinList[pin_id];
-                if (inRegion(1, pin, current_pin)) {
-                    _edgeList.push_back(Edge(pin_id, current_pin_id, getDistance(pin, current_pin)));
-                    it = actSet1.erase(it);
+                const Pin<Coord>& pin = pinList[pin_id];
+                if (inRegion(r, pin, current_pin)) {
+                    edgeList.push_back(Edge<Coord>(pin_id, current_pin_id, getDistance(pin, current_pin)));
+                    it = actSet.erase(it);
                 }
                 else {
                     break;
@@ -150,170 +399,543 @@ void Router::genSpanningGraph()
                 ++it;
             }
         }
+        offset[i+1] = edgeList.size();
+    }
+    return;
+}
 
-        // Region 2
-        for (auto it = actSet2.upper_bound(current_pin._y); it != actSet2.end();) {
-            const int pin_id = it->second;
-            if (pin_id != current_pin_id) {
-                const Pin& pin = _pinList[pin_id];
-                if (inRegion(2, pin, current_pin)) {
-                    _edgeList.push_back(Edge(pin_id, current_pin_id, getDistance(pin, current_pin)));
-                    it = actSet2.erase(it);
+template <class Coord>
+void Router<Coord>::sweepMultimap()
+{
+    size_t threadNum = getThreadNum(_option._threadNum);
+    size_t pinNum = _pinList.size();
+    ArenaVector<Index> pinIds1(pinNum, 0, &_arena);
+    iota(pinIds1.begin(), pinIds1.end(), 0);
+    ArenaVector<Index> pinIds2(pinIds1.begin(), pinIds1.end(), &_arena);
+
+    // sort by x + y (regions 1, 2) and by x - y (regions 3, 4)
+    parallelRun(2, threadNum, [&](size_t i) {
+        size_t sortThreadNum = max(threadNum / 2, (size_t)1);
+        if (i == 0) {
+            parallelSort(pinIds1.begin(), pinIds1.end(),
+                 [&](Index id1, Index id2) {
+                 const Pin<Coord>& pin1 = _pinList[id1];
+                 const Pin<Coord>& pin2 = _pinList[id2];
+                 return (pin1._x + pin1._y < pin2._x + pin2._y);
+            }, sortThreadNum);
+        }
+        else {
+            parallelSort(pinIds2.begin(), pinIds2.end(),
+                 [&](Index id1, Index id2) {
+                 const Pin<Coord>& pin1 = _pinList[id1];
+                 const Pin<Coord>& pin2 = _pinList[id2];
+                 return (pin1._x - pin1._y < pin2._x - pin2._y);
+            }, sortThreadNum);
+        }
+    });
+
+    // the four regions do not interact: sweep them concurrently, each with
+    // an arena of its own
+    vector<ArenaVector<Edge<Coord> > > edgeList;
+    vector<ArenaVector<size_t> > offset;
+    for (size_t r = 0; r < 4; ++r) {
+        edgeList.push_back(ArenaVector<Edge<Coord> >(&_sweepArena[r]));
+        offset.push_back(ArenaVector<size_t>(&_sweepArena[r]));
+    }
+    parallelRun(4, threadNum, [&](size_t r) {
+        ArenaAllocator<pair<const Coord, Index> > alloc(&_sweepArena[r]);
+        if (r == 0) {
+            rev_multimap<Coord> actSet1(alloc);
+            sweepRegion(1, actSet1, true, false, _pinList, pinIds1, edgeList[r], offset[r]);
+        }
+        else if (r == 1) {
+            rev_multimap<Coord> actSet2(alloc);
+            sweepRegion(2, actSet2, false, true, _pinList, pinIds1, edgeList[r], offset[r]);
+        }
+        else if (r == 2) {
+            fwd_multimap<Coord> actSet3(alloc);
+            sweepRegion(3, actSet3, false, false, _pinList, pinIds2, edgeList[r], offset[r]);
+        }
+        else {
+            rev_multimap<Coord> actSet4(alloc);
+            sweepRegion(4, actSet4, true, true, _pinList, pinIds2, edgeList[r], offset[r]);
+        }
+    });
+
+    // merge in the order the sequential sweep would have produced
+    size_t edgeNum = _edgeList.size();
+    for (size_t r = 0; r < 4; ++r) edgeNum += edgeList[r].size();
+    _edgeList.reserve(edgeNum);
+    for (size_t r = 0; r < 4; r += 2) {
+        for (size_t i = 0; i < pinNum; ++i) {
+            _edgeList.insert(_edgeList.end(), edgeList[r].begin() + offset[r][i],
+                             edgeList[r].begin() + offset[r][i+1]);
+            _edgeList.insert(_edgeList.end(), edgeList[r+1].begin() + offset[r+1][i],
+                             edgeList[r+1].begin() + offset[r+1][i+1]);
+        }
+    }
+    return;
+}
+
+template <class Coord>
+void Router<Coord>::genSpanningTree()
+{
+    _treeList.clear();
+    _treeId.clear();
+
+    // build up adjacency list
+    ArenaVector<size_t> adjStart(&_arena);
+    ArenaVector<Index> adjPin(&_arena);
+    this->getAdjacency(_edgeList, adjStart, adjPin);
+
+    // Kruskal algorithm, edges in stable order of cost
+    typedef typename make_unsigned<Coord>::type UCoord;
+    size_t threadNum = getThreadNum(_option._threadNum);
+    radixSort(_edgeList, [](const Edge<Coord>& edge) {
+        return (UCoord)edge._cost;
+    }, threadNum);
+    MergeTree<Coord> mergeTree(_pinList, _edgeList, _arena);
+    auto addTreeEdge = [&](size_t i) {
+        _treeList.push_back(_edgeList[i]);
+        _treeId.push_back(i);
+        mergeTree.addEdge(i);
+    };
+
+    if (_option._filterKruskal) {
+        // tree edges from the parallel engine, replayed in merge order
+        vector<Index> treeEdge;
+        FilterKruskal<Coord> mst(threadNum);
+        mst.genTree(_pinNum, _edgeList, treeEdge);
+        for (size_t i = 0, end_i = treeEdge.size(); i < end_i; ++i) {
+            addTreeEdge(treeEdge[i]);
+        }
+    }
+    else {
+        for (size_t i = 0, end_i = _edgeList.size(); i < end_i; ++i) {
+            const Edge<Coord>& edge = _edgeList[i];
+            size_t s1 = mergeTree.findSet(edge._s);
+            size_t s2 = mergeTree.findSet(edge._t);
+            if (s1 != s2) {
+                addTreeEdge(i);
+            }
+        }
+    }
+
+    // queries of the tree edges in merge order; a query only names the
+    // pins and the edge, so the slots are counted and taken at once
+    size_t queryNum = 0;
+    for (size_t k = 0, end_k = _treeList.size(); k < end_k; ++k) {
+        const Edge<Coord>& edge = _treeList[k];
+        queryNum += adjStart[edge._s + 1] - adjStart[edge._s];
+        queryNum += adjStart[edge._t + 1] - adjStart[edge._t];
+    }
+    mergeTree.reserveQuery(queryNum);
+    for (size_t k = 0, end_k = _treeList.size(); k < end_k; ++k) {
+        const Edge<Coord>& edge = _treeList[k];
+        for (size_t j = adjStart[edge._s], end_j = adjStart[edge._s + 1]; j < end_j; ++j) {
+            mergeTree.addQuery(adjPin[j], edge._s, _treeId[k]);
+        }
+        for (size_t j = adjStart[edge._t], end_j = adjStart[edge._t + 1]; j < end_j; ++j) {
+            mergeTree.addQuery(adjPin[j], edge._t, _treeId[k]);
+        }
+    }
+    mergeTree.answerQuery(threadNum);
+    mergeTree.getQueryList(_queryList, threadNum);
+
+    return;
+}
+
+template <class Coord>
+void Router<Coord>::genSteinerTree()
+{
+    // tree edges are alive until a query replaces them
+    vector<uint8_t> alive(_edgeList.size(), 0);
+    for (size_t i = 0, end = _treeId.size(); i < end; ++i) {
+        alive[_treeId[i]] = 1;
+    }
+
+    vector<Edge<Coord> > treeList;
+    treeList.reserve(_treeList.size() + 2 * _queryList.size());
+    _pinList.reserve(_pinNum + _queryList.size());
+    if (_option._batchSteiner) {
+        this->insertSteinerBatch(alive, treeList);
+    }
+    else {
+        for (size_t i = 0, end = _queryList.size(); i < end; ++i) {
+            const Query<Coord>& query = _queryList[i];
+            if (alive[query._cEdge] && alive[query._dEdge]) {
+                alive[query._cEdge] = 0;
+                alive[query._dEdge] = 0;
+                _pinList.resize(_pinNum + 1);
+                treeList.resize(treeList.size() + 3);
+                this->addSteinerPin(query, _pinNum, &treeList[treeList.size() - 3]);
+                _pinNum += 1;
+            }
+        }
+    }
+
+    // untouched edges
+    for (size_t i = 0, end = _treeId.size(); i < end; ++i) {
+        if (alive[_treeId[i]]) {
+            treeList.push_back(_treeList[i]);
+        }
+    }
+    _treeList.swap(treeList);
+    return;
+}
+
+// pins on the edges added by the last round, whose Steiner pins have ids
+// from firstPin on
+template <class Coord>
+void Router<Coord>::getChangedPins(size_t firstPin, vector<uint8_t>& dirty) const
+{
+    dirty.assign(_pinNum, 0);
+    for (size_t i = 0, end = _treeList.size(); i < end; ++i) {
+        const Edge<Coord>& edge = _treeList[i];
+        if (edge._t >= firstPin) {
+            dirty[edge._s] = 1;
+            dirty[edge._t] = 1;
+        }
+    }
+    return;
+}
+
+// Adjacency of the edges in compressed form, in two counting passes: the
+// neighbors of pin p are adjPin[adjStart[p], adjStart[p+1]), in edge order.
+template <class Coord>
+void Router<Coord>::getAdjacency(const vector<Edge<Coord> >& edgeList,
+                                 ArenaVector<size_t>& adjStart, ArenaVector<Index>& adjPin)
+{
+    size_t edgeNum = edgeList.size();
+    adjStart.assign(_pinNum + 1, 0);
+    for (size_t i = 0; i < edgeNum; ++i) {
+        ++adjStart[edgeList[i]._s + 1];
+        ++adjStart[edgeList[i]._t + 1];
+    }
+    partial_sum(adjStart.begin(), adjStart.end(), adjStart.begin());
+
+    ArenaVector<size_t> next(adjStart.begin(), adjStart.end() - 1, &_arena);
+    adjPin.resize(2 * edgeNum);
+    for (size_t i = 0; i < edgeNum; ++i) {
+        const Edge<Coord>& edge = edgeList[i];
+        adjPin[next[edge._s]++] = edge._t;
+        adjPin[next[edge._t]++] = edge._s;
+    }
+    return;
+}
+
+// Another round of edge substitution on the Steiner tree, with the Steiner
+// pins of the former rounds taking part. The tree becomes the edge list.
+// Candidates of a tree edge are the pins within two tree hops of its ends,
+// and only the neighborhoods around the dirty pins produce queries: the
+// edge, or the candidate, touches a dirty pin.
+template <class Coord>
+void Router<Coord>::refineSteinerTree(const vector<uint8_t>& dirty)
+{
+    typedef typename make_unsigned<Coord>::type UCoord;
+    size_t threadNum = getThreadNum(_option._threadNum);
+
+    ArenaVector<size_t> adjStart(&_arena);
+    ArenaVector<Index> adjPin(&_arena);
+    this->getAdjacency(_treeList, adjStart, adjPin);
+
+    // every tree edge merges, so no Kruskal check is needed
+    _edgeList.swap(_treeList);
+    radixSort(_edgeList, [](const Edge<Coord>& edge) {
+        return (UCoord)edge._cost;
+    }, threadNum);
+    _treeList = _edgeList;
+    _treeId.resize(_edgeList.size());
+    iota(_treeId.begin(), _treeId.end(), 0);
+
+    MergeTree<Coord> mergeTree(_pinList, _edgeList, _arena);
+    for (size_t i = 0, end_i = _edgeList.size(); i < end_i; ++i) {
+        const Edge<Coord>& edge = _edgeList[i];
+        bool changed = dirty[edge._s] || dirty[edge._t];
+        for (size_t k = 0; k < 2; ++k) {
+            size_t u = (k == 0)? edge._s: edge._t;
+            size_t other = (k == 0)? edge._t: edge._s;
+            for (size_t j = adjStart[u], end_j = adjStart[u + 1]; j < end_j; ++j) {
+                size_t v = adjPin[j];
+                if (v != other && (changed || dirty[v])) {
+                    mergeTree.addQuery(v, u, i);
                 }
-                else {
-                    break;
+                for (size_t l = adjStart[v], end_l = adjStart[v + 1]; l < end_l; ++l) {
+                    size_t w = adjPin[l];
+                    if (w != u && (changed || dirty[w])) {
+                        mergeTree.addQuery(w, u, i);
+                    }
                 }
             }
-            else {
-                ++it;
-            }
         }
+        mergeTree.addEdge(i);
     }
+    mergeTree.answerQuery(threadNum);
+    mergeTree.getQueryList(_queryList, threadNum);
+
+    this->genSteinerTree();
+    return;
+}
+
+// Queries are taken in windows of a fixed size, in gain order. Every query
+// of the window whose edges are both alive reserves them with its index,
+// and the smallest index wins an edge. A query holding both reservations
+// is committed; its Steiner pin id comes from a prefix sum over the
+// window. A query that lost a reservation but still has both edges alive
+// is retried in the next window ahead of the new queries, so the accepted
+// queries are the sequential greedy ones. With _steinerTol > 0 such a
+// query is dropped instead while the dropped gain stays within _steinerTol
+// times the cost of the spanning tree.
+template <class Coord>
+void Router<Coord>::insertSteinerBatch(vector<uint8_t>& alive, vector<Edge<Coord> >& treeList)
+{
+    static const Index NONE = (Index)-1;
+    static const size_t WINDOW = 1 << 14;
+    size_t threadNum = getThreadNum(_option._threadNum);
+    size_t queryNum = _queryList.size();
+    long budget = (long)(_option._steinerTol * this->getCost(_treeList));
 
-    // sort by x - y
-    sort(pinIds.begin(), pinIds.end(),
-         [&](int id1, int id2) {
-         const Pin& pin1 = _pinList[id1];
-         const Pin& pin2 = _pinList[id2];
-         return (pin1._x - pin1._y < pin2._x - pin2._y);
+    vector<atomic<Index> > reserve(_edgeList.size());
+    parallelFor(reserve.size(), (reserve.size() < (1 << 16))? 1: threadNum,
+                [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            reserve[i].store(NONE, memory_order_relaxed);
+        }
     });
+    auto reserveEdge = [&](size_t e, Index id) {
+        Index cur = reserve[e].load(memory_order_relaxed);
+        while (id < cur && !reserve[e].compare_exchange_weak(cur, id, memory_order_relaxed));
+    };
 
-    for (size_t i = 0, end = pinIds.size(); i < end; ++i) {
-        size_t current_pin_id = pinIds[i];
-        const Pin& current_pin = _pinList[current_pin_id];
-        actSet3.insert(make_pair(current_pin._y, current_pin_id));
-        actSet4.insert(make_pair(current_pin._x, current_pin_id));
+    vector<Index> window, retry;
+    vector<uint8_t> state;      // 0: dead, 1: lost, 2: won
+    vector<Index> offset;
+    size_t next = 0;
+    while (next < queryNum || !window.empty()) {
+        while (window.size() < WINDOW && next < queryNum) {
+            window.push_back(next++);
+        }
+        size_t n = window.size();
+        size_t tn = (n < (1 << 12))? 1: threadNum;
+        state.resize(n);
+        offset.resize(n);
 
-        // Region 3
-        for (auto it = actSet3.lower_bound(current_pin._y); it != actSet3.end();) {
-            const int pin_id = it->second;
-            if (pin_id != current_pin_id) {
-                const Pin& pin = _pinList[pin_id];
-                if (inRegion(3, pin, current_pin)) {
-                    _edgeList.push_back(Edge(pin_id, current_pin_id, getDistance(pin, current_pin)));
-                    it = actSet3.erase(it);
+        // reserve
+        parallelFor(n, tn, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Query<Coord>& query = _queryList[window[i]];
+                if (alive[query._cEdge] && alive[query._dEdge]) {
+                    reserveEdge(query._cEdge, window[i]);
+                    reserveEdge(query._dEdge, window[i]);
+                }
+            }
+        });
+
+        // check
+        parallelFor(n, tn, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Query<Coord>& query = _queryList[window[i]];
+                if (!alive[query._cEdge] || !alive[query._dEdge]) {
+                    state[i] = 0;
                 }
                 else {
-                    break;
+                    state[i] = (reserve[query._cEdge].load(memory_order_relaxed) == window[i] &&
+                                reserve[query._dEdge].load(memory_order_relaxed) == window[i])? 2: 1;
                 }
             }
-            else {
-                ++it;
+        });
+
+        // release, and kill the edges of the winners
+        parallelFor(n, tn, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (state[i] == 0) continue;
+                const Query<Coord>& query = _queryList[window[i]];
+                reserve[query._cEdge].store(NONE, memory_order_relaxed);
+                reserve[query._dEdge].store(NONE, memory_order_relaxed);
+                if (state[i] == 2) {
+                    alive[query._cEdge] = 0;
+                    alive[query._dEdge] = 0;
+                }
             }
-        }
+        });
 
-        // Region 4
-        for (auto it = actSet4.upper_bound(current_pin._x); it != actSet4.end();) {
-            const int pin_id = it->second;
-            if (pin_id != current_pin_id) {
-                const Pin& pin = _pinList[pin_id];
-                if (inRegion(4, pin, current_pin)) {
-                    _edgeList.push_back(Edge(pin_id, current_pin_id, getDistance(pin, current_pin)));
-                    it = actSet4.erase(it);
+        // pin ids of the winners, and the queries to retry
+        size_t winNum = 0;
+        retry.clear();
+        for (size_t i = 0; i < n; ++i) {
+            offset[i] = winNum;
+            if (state[i] == 2) {
+                ++winNum;
+            }
+            else if (state[i] == 1) {
+                const Query<Coord>& query = _queryList[window[i]];
+                if (query._gain <= budget) {
+                    budget -= query._gain;
                 }
                 else {
-                    break;
+                    retry.push_back(window[i]);
                 }
             }
-            else {
-                ++it;
-            }
         }
+
+        // commit
+        size_t pinBase = _pinNum;
+        size_t edgeBase = treeList.size();
+        _pinList.resize(pinBase + winNum);
+        treeList.resize(edgeBase + 3 * winNum);
+        parallelFor(n, tn, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (state[i] != 2) continue;
+                this->addSteinerPin(_queryList[window[i]], pinBase + offset[i],
+                                    &treeList[edgeBase + 3 * offset[i]]);
+            }
+        });
+        _pinNum += winNum;
+        window.swap(retry);
     }
     return;
 }
 
-void Router::genSpanningTree()
+// Steiner pin of a query, the point of the cEdge box nearest to w, and
+// its three edges to w and the ends of the cEdge.
+template <class Coord>
+void Router<Coord>::addSteinerPin(const Query<Coord>& query, size_t pinId, Edge<Coord>* edge)
 {
-    _treeList.clear();
+    const Edge<Coord>& cEdge = _edgeList[query._cEdge];
+    Coord x  = _pinList[query._w]._x, y  = _pinList[query._w]._y;
+    Coord sx = _pinList[cEdge._s]._x, sy = _pinList[cEdge._s]._y;
+    Coord tx = _pinList[cEdge._t]._x, ty = _pinList[cEdge._t]._y;
+    Coord maxX = max(sx, tx), minX = min(sx, tx);
+    Coord maxY = max(sy, ty), minY = min(sy, ty);
+    Coord newX = (x > maxX)? maxX: (x < minX)? minX: x;
+    Coord newY = (y > maxY)? maxY: (y < minY)? minY: y;
 
-    // build up adjacency list
-    vector<vector<size_t> > adjList(_pinNum);
-    for (size_t i = 0, end = _edgeList.size(); i < end; ++i) {
-        const Edge& edge = _edgeList[i];
-        adjList[edge._s].push_back(edge._t);
-        adjList[edge._t].push_back(edge._s);
+    Pin<Coord> newPin(newX, newY);
+    _pinList[pinId] = newPin;
+    edge[0] = Edge<Coord>(query._w, pinId, getDistance(_pinList[query._w], newPin));
+    edge[1] = Edge<Coord>(cEdge._s, pinId, getDistance(_pinList[cEdge._s], newPin));
+    edge[2] = Edge<Coord>(cEdge._t, pinId, getDistance(_pinList[cEdge._t], newPin));
+    return;
+}
+
+// Corners of the diagonal tree edges, 1 for the L at (t._x, s._y) and 0
+// for the L at (s._x, t._y). Two Ls that leave a pin into the same
+// quadrant, one horizontally and one vertically, cross when each turns
+// within the span of the other; one of them is then flipped to run along
+// the other. An edge is flipped at most once, and the pin at its far end is
+// checked again.
+template <class Coord>
+void Router<Coord>::untangleCorners(vector<uint8_t>& corner) const
+{
+    size_t edgeNum = _treeList.size();
+    auto isDiagonal = [&](size_t i) {
+        const Pin<Coord>& s = _pinList[_treeList[i]._s];
+        const Pin<Coord>& t = _pinList[_treeList[i]._t];
+        return (s._x != t._x && s._y != t._y);
+    };
+
+    // diagonal edges of each pin
+    vector<Index> start(_pinNum + 1, 0);
+    for (size_t i = 0; i < edgeNum; ++i) {
+        if (!isDiagonal(i)) continue;
+        ++start[_treeList[i]._s + 1];
+        ++start[_treeList[i]._t + 1];
+    }
+    partial_sum(start.begin(), start.end(), start.begin());
+    vector<Index> incident(start[_pinNum]);
+    vector<Index> next(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < edgeNum; ++i) {
+        if (!isDiagonal(i)) continue;
+        incident[next[_treeList[i]._s]++] = i;
+        incident[next[_treeList[i]._t]++] = i;
     }
 
-    // Kruskal algorithm
-    sort(_edgeList.begin(), _edgeList.end(), SortEdgeCost());
-    MergeTree mergeTree(_pinList);
-    for (size_t i = 0, end_i = _edgeList.size(); i < end_i; ++i) {
-        const Edge& edge = _edgeList[i];
-        size_t s1 = mergeTree.findSet(edge._s);
-        size_t s2 = mergeTree.findSet(edge._t);
-        if (s1 != s2) {
-            _treeList.push_back(edge);
-            for (size_t j = 0, end_j = adjList[edge._s].size(); j < end_j; ++j) {
-                mergeTree.addQuery(adjList[edge._s][j], edge._s, edge);
-            }
-            for (size_t j = 0, end_j = adjList[edge._t].size(); j < end_j; ++j) {
-                mergeTree.addQuery(adjList[edge._t][j], edge._t, edge);
+    vector<uint8_t> flipped(edgeNum, 0);
+    vector<Index> work;
+    for (size_t p = 0; p < _pinNum; ++p) {
+        if (start[p + 1] - start[p] > 1) work.push_back(p);
+    }
+    while (!work.empty()) {
+        size_t p = work.back();
+        work.pop_back();
+        const Pin<Coord>& pin = _pinList[p];
+        for (size_t j = start[p]; j < start[p + 1]; ++j) {
+            for (size_t k = j + 1; k < start[p + 1]; ++k) {
+                size_t a = incident[j], b = incident[k];
+                size_t qa = (_treeList[a]._s == p)? _treeList[a]._t: _treeList[a]._s;
+                size_t qb = (_treeList[b]._s == p)? _treeList[b]._t: _treeList[b]._s;
+                long dxa = (long)_pinList[qa]._x - pin._x, dya = (long)_pinList[qa]._y - pin._y;
+                long dxb = (long)_pinList[qb]._x - pin._x, dyb = (long)_pinList[qb]._y - pin._y;
+                if ((dxa > 0) != (dxb > 0) || (dya > 0) != (dyb > 0)) continue;
+                bool hFirstA = ((_treeList[a]._s == p) == (corner[a] == 1));
+                bool hFirstB = ((_treeList[b]._s == p) == (corner[b] == 1));
+                if (hFirstA == hFirstB) continue;
+                // let a leave p horizontally and b vertically
+                if (hFirstB) {
+                    swap(a, b);
+                    swap(qa, qb);
+                    swap(dxa, dxb);
+                    swap(dya, dyb);
+                }
+                if (labs(dxa) > labs(dxb) || labs(dyb) > labs(dya)) continue;
+                size_t e = flipped[b]? a: b;
+                if (flipped[e]) continue;
+                corner[e] ^= 1;
+                flipped[e] = 1;
+                work.push_back((e == a)? qa: qb);
             }
-            mergeTree.addEdge(edge);
         }
     }
-    mergeTree.answerQuery();
-    mergeTree.getQueryList(_queryList);
-
     return;
 }
 
-void Router::genSteinerTree()
+template <class Coord>
+void Router<Coord>::rectilinearize()
 {
-    set<Edge, EdgeCmp> edgeList;
-
+    // runs of the straight edges, to pick the L of a diagonal edge that
+    // overlaps them most
+    LineRuns<Coord> hRun, vRun;
+    vector<Segment<Coord> > hSeg, vSeg;
     for (size_t i = 0, end = _treeList.size(); i < end; ++i) {
-        edgeList.insert(_treeList[i]);
+        const Pin<Coord>& s = _pinList[_treeList[i]._s];
+        const Pin<Coord>& t = _pinList[_treeList[i]._t];
+        if (s._y == t._y && s._x != t._x) {
+            hSeg.push_back(Segment<Coord>(s._y, min(s._x, t._x), max(s._x, t._x)));
+        }
+        else if (s._x == t._x && s._y != t._y) {
+            vSeg.push_back(Segment<Coord>(s._x, min(s._y, t._y), max(s._y, t._y)));
+        }
     }
+    hRun.build(hSeg);
+    vRun.build(vSeg);
 
-    _treeList.clear();
-    for (size_t i = 0, end = _queryList.size(); i < end; ++i) {
-        const Query& query = _queryList[i];
-        const Edge& cEdge = query._cEdge;
-        const Edge& dEdge = query._dEdge;
-        auto it1 = edgeList.find(cEdge);
-        auto it2 = edgeList.find(dEdge);
-
-        if (it1 != edgeList.end() && it2 != edgeList.end()) {
-            edgeList.erase(it1);
-            edgeList.erase(it2);
-            int x  = _pinList[query._w]._x, y  = _pinList[query._w]._y;
-            int sx = _pinList[cEdge._s]._x, sy = _pinList[cEdge._s]._y;
-            int tx = _pinList[cEdge._t]._x, ty = _pinList[cEdge._t]._y;
-            int maxX = max(sx, tx), minX = min(sx, tx);
-            int maxY = max(sy, ty), minY = min(sy, ty);
-            int newX = (x > maxX)? maxX: (x < minX)? minX: x;
-            int newY = (y > maxY)? maxY: (y < minY)? minY: y;
-
-            Pin newPin(newX, newY, _pinNum);
-            _pinList.push_back(newPin);
-            _treeList.push_back(Edge(query._w, _pinNum, getDistance(_pinList[query._w], newPin)));
-            _treeList.push_back(Edge(cEdge._s, _pinNum, getDistance(_pinList[cEdge._s], newPin)));
-            _treeList.push_back(Edge(cEdge._t, _pinNum, getDistance(_pinList[cEdge._t], newPin)));
-            _pinNum += 1;
+    vector<uint8_t> corner(_treeList.size(), 0);
+    for (size_t i = 0, end = _treeList.size(); i < end; ++i) {
+        const Pin<Coord>& s = _pinList[_treeList[i]._s];
+        const Pin<Coord>& t = _pinList[_treeList[i]._t];
+        if (s._x != t._x && s._y != t._y) {
+            Coord minX = min(s._x, t._x), maxX = max(s._x, t._x);
+            Coord minY = min(s._y, t._y), maxY = max(s._y, t._y);
+            // corner (s._x, t._y) or (t._x, s._y)
+            Coord overlap1 = vRun.getOverlap(s._x, minY, maxY) + hRun.getOverlap(t._y, minX, maxX);
+            Coord overlap2 = hRun.getOverlap(s._y, minX, maxX) + vRun.getOverlap(t._x, minY, maxY);
+            corner[i] = (overlap2 > overlap1);
         }
     }
+    this->untangleCorners(corner);
 
-    // untouched edges
-    for (auto it1 = edgeList.begin(); it1 != edgeList.end(); ++it1) {
-        _treeList.push_back(*it1);
-    }
-    return;
-}
-
-void Router::rectilinearize()
-{
-    for (size_t i = 0, end = _treeList.size(); i < end; ++i) {
-        Edge& edge = _treeList[i];
-        const Pin& s = _pinList[edge._s];
-        const Pin& t = _pinList[edge._t];
+    _pinList.reserve(_pinNum + _treeList.size());
+    _treeList.reserve(2 * _treeList.size());
+    for (size_t i = 0, end = corner.size(); i < end; ++i) {
+        Edge<Coord>& edge = _treeList[i];
+        const Pin<Coord>& s = _pinList[edge._s];
+        const Pin<Coord>& t = _pinList[edge._t];
         if (s._x != t._x && s._y != t._y) {
-            Pin newPin(s._x, t._y, _pinNum, "");
+            Pin<Coord> newPin = corner[i]? Pin<Coord>(t._x, s._y): Pin<Coord>(s._x, t._y);
             // Note: _pinList.push_back(newPin) should never done before using s and t
             // Due to the redistribution of memory of a vector, calling s and t after
             // push_back() will cause a core dump
-            _treeList.push_back(Edge(s._id, _pinNum, getDistance(s, newPin)));
+            _treeList.push_back(Edge<Coord>(edge._s, _pinNum, getDistance(s, newPin)));
             _treeList[i]._s = _pinNum;
             _treeList[i]._cost = getDistance(t, newPin);
             _pinList.push_back(newPin);
@@ -324,32 +946,701 @@ void Router::rectilinearize()
     return;
 }
 
-void Router::route()
+template <class Coord>
+void Router<Coord>::route()
 {
     _start = clock();
+    _tileNum = 0;
+    _levelNum = 0;
+    _flatCost = -1;
+    _changeNum = 0;
+    _totalChangeNum = 0;
+    _rerouteNum = 0;
+    _repairTime = 0;
+    _ecoSeed.clear();
+    this->dedupPins();
+    if (_option._hilbertOrder) {
+        this->reorderPins();
+    }
+    this->routeTree();
+    if (_option._incremental) {
+        _eco.build(_pinList, _treeList, vector<Index>());
+        for (size_t i = 0; i < _uPinNum; ++i) {
+            _eco.addName(_pinName[i].str(), i);
+        }
+        for (size_t i = 0, end = _dupPin.size(); i < end; ++i) {
+            _eco.addName(_pinName[_uPinNum + i].str(), _dupPin[i]);
+        }
+    }
+    this->releaseScratch();
+    this->rectilinearize();
+    if (_option._compact) {
+        _compactor.compact(_pinList, _uPinNum, _treeList);
+        _pinNum = _pinList.size();
+    }
+    _stop = clock();
+
+    if ((_tileNum > 0 || _levelNum > 0) && _option._flatCompare) {
+        Router<Coord> flat;
+        flat._option = _option;
+        flat._option._tileSize = 0;
+        flat._option._multilevel = false;
+        flat._option._incremental = false;
+        flat._pinList.assign(_pinList.begin(), _pinList.begin() + _uPinNum);
+        flat._pinName.assign(_pinName.begin(), _pinName.begin() + _uPinNum);
+        flat._pinNum = flat._oPinNum = flat._uPinNum = _uPinNum;
+        flat.route();
+        _flatCost = flat.getWireLength();
+    }
+    return;
+}
+
+// Steiner tree of the distinct pins by the mode of the options.
+template <class Coord>
+void Router<Coord>::routeTree()
+{
+    bool routed = false;
+    if (_option._tileSize > 0) {
+        routed = this->routeTiled();
+    }
+    else if (_option._multilevel) {
+        routed = this->routeMultilevel();
+    }
+    if (!routed) {
+        this->routeFlat();
+    }
+    return;
+}
+
+// Steiner tree of the (distinct) pins, before rectilinearization.
+template <class Coord>
+void Router<Coord>::routeFlat()
+{
+    if (this->routeSmall()) return;
+
     this->genSpanningGraph();
     this->genSpanningTree();
+    size_t firstPin = _pinNum;
     this->genSteinerTree();
+
+    long cost = this->getCost(_treeList);
+    vector<uint8_t> dirty;
+    for (size_t pass = 1; pass < _option._steinerPass; ++pass) {
+        size_t pinNum = _pinNum;
+        this->getChangedPins(firstPin, dirty);
+        refineSteinerTree(dirty);
+        firstPin = pinNum;
+        long newCost = this->getCost(_treeList);
+        bool stop = (cost - newCost <= _option._passGain * cost);
+        cost = newCost;
+        if (stop) break;
+    }
+    return;
+}
+
+// Multilevel mode. The pins are clustered on a grid whose cell doubles at
+// every level; each cluster is represented on the next level by the member
+// nearest its centroid. Coarsening stops at COARSE_PIN_NUM pins, or once a
+// level hardly shrinks. The coarsest level gets a spanning tree. Going back
+// down, Kruskal runs over the tree so far and the candidate edges of the
+// finer level: every pin to its representative and to its nearest pins in
+// the 3x3 cells around it, so short links between neighboring clusters
+// replace the long links between their representatives. Pins of the finer
+// levels stay isolated until then. A substitution round over the final
+// tree adds the Steiner points. It runs once at the end rather than on
+// every level: a Steiner point placed between representatives can be
+// neither moved nor removed by the finer levels, which costs more
+// wirelength than the extra rounds save. Returns false for nets too small
+// to coarsen.
+template <class Coord>
+bool Router<Coord>::routeMultilevel()
+{
+    typedef typename make_unsigned<Coord>::type UCoord;
+    typedef unsigned long long Key;
+    static const size_t COARSE_PIN_NUM = 1 << 10;
+    static const size_t NEAR_NUM = 3;
+    static const Index NONE = (Index)-1;
+    size_t threadNum = getThreadNum(_option._threadNum);
+    size_t pinNum = _pinNum;
+    if (pinNum <= COARSE_PIN_NUM) return false;
+
+    long minX = _pinList[0]._x, maxX = minX;
+    long minY = _pinList[0]._y, maxY = minY;
+    for (size_t i = 1; i < pinNum; ++i) {
+        minX = min(minX, (long)_pinList[i]._x);
+        maxX = max(maxX, (long)_pinList[i]._x);
+        minY = min(minY, (long)_pinList[i]._y);
+        maxY = max(maxY, (long)_pinList[i]._y);
+    }
+    // about four pins per cell on the finest level
+    double cell = sqrt(4.0 * (maxX - minX + 1) * (maxY - minY + 1) / pinNum);
+
+    // pins of each level, their cells (sorted), and their representatives
+    vector<vector<Index> > levelPin(1, vector<Index>(pinNum));
+    vector<vector<Index> > levelRep;
+    vector<long> levelCell;
+    iota(levelPin[0].begin(), levelPin[0].end(), 0);
+    while (levelPin.back().size() > COARSE_PIN_NUM) {
+        vector<Index>& pin = levelPin.back();
+        size_t num = pin.size();
+        long size = max((long)cell, 1L);
+        Key colNum = (maxX - minX) / size + 1;
+        auto getKey = [&](size_t p) {
+            return (Key)((_pinList[p]._y - minY) / size) * colNum + (Key)((_pinList[p]._x - minX) / size);
+        };
+        radixSort(pin, getKey, threadNum);
+
+        vector<Index> rep(num);
+        vector<Index> next;
+        for (size_t a = 0, b = 0; a < num; a = b) {
+            Key key = getKey(pin[a]);
+            double cx = 0, cy = 0;
+            for (b = a; b < num && getKey(pin[b]) == key; ++b) {
+                cx += _pinList[pin[b]]._x;
+                cy += _pinList[pin[b]]._y;
+            }
+            cx /= (b - a);
+            cy /= (b - a);
+            size_t best = pin[a];
+            double bestDist = fabs(_pinList[best]._x - cx) + fabs(_pinList[best]._y - cy);
+            for (size_t j = a + 1; j < b; ++j) {
+                double dist = fabs(_pinList[pin[j]]._x - cx) + fabs(_pinList[pin[j]]._y - cy);
+                if (dist < bestDist) {
+                    best = pin[j];
+                    bestDist = dist;
+                }
+            }
+            fill(rep.begin() + a, rep.begin() + b, best);
+            next.push_back(best);
+        }
+        if (next.size() * 10 > num * 9) break;
+        levelRep.push_back(rep);
+        levelCell.push_back(size);
+        levelPin.push_back(next);
+        cell *= 2;
+    }
+    if (levelRep.empty()) return false;
+    _levelNum = levelPin.size();
+
+    // spanning tree of the coarsest level
+    _treeList.clear();
+    this->routeSubnet(levelPin.back(), false);
+
+    // uncoarsen
+    vector<Index> par(_pinNum);
+    vector<Edge<Coord> > edgeList;
+    for (size_t l = levelRep.size(); l-- > 0; ) {
+        const vector<Index>& pin = levelPin[l];
+        const vector<Index>& rep = levelRep[l];
+        size_t num = pin.size();
+        long size = levelCell[l];
+        Key colNum = (maxX - minX) / size + 1;
+        Key rowNum = (maxY - minY) / size + 1;
+        vector<Key> key(num);
+        for (size_t i = 0; i < num; ++i) {
+            key[i] = (Key)((_pinList[pin[i]]._y - minY) / size) * colNum +
+                     (Key)((_pinList[pin[i]]._x - minX) / size);
+        }
+
+        // nearest pins in the 3x3 cells around each pin (pin is in cell order)
+        vector<Index> nearPin(num * NEAR_NUM, NONE);
+        parallelFor(num, (num < (1 << 14))? 1: threadNum, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Pin<Coord>& p = _pinList[pin[i]];
+                Key row = key[i] / colNum, col = key[i] % colNum;
+                Coord nearDist[NEAR_NUM];
+                Index* near = &nearPin[i * NEAR_NUM];
+                for (Key r = (row > 0)? row - 1: 0; r <= row + 1 && r < rowNum; ++r) {
+                    Key c0 = (col > 0)? col - 1: 0;
+                    Key c1 = min(col + 1, colNum - 1);
+                    size_t j = lower_bound(key.begin(), key.end(), r * colNum + c0) - key.begin();
+                    for (; j < num && key[j] <= r * colNum + c1; ++j) {
+                        if (j == i) continue;
+                        Coord d = getDistance(p, _pinList[pin[j]]);
+                        for (size_t k = 0; k < NEAR_NUM; ++k) {
+                            if (near[k] == NONE || d < nearDist[k]) {
+                                for (size_t m = NEAR_NUM - 1; m > k; --m) {
+                                    near[m] = near[m - 1];
+                                    nearDist[m] = nearDist[m - 1];
+                                }
+                                near[k] = pin[j];
+                                nearDist[k] = d;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+        // Kruskal over the tree and the candidates
+        edgeList.swap(_treeList);
+        for (size_t i = 0; i < num; ++i) {
+            if (pin[i] != rep[i]) {
+                edgeList.push_back(Edge<Coord>(pin[i], rep[i], getDistance(_pinList[pin[i]], _pinList[rep[i]])));
+            }
+            for (size_t k = 0; k < NEAR_NUM && nearPin[i * NEAR_NUM + k] != NONE; ++k) {
+                size_t q = nearPin[i * NEAR_NUM + k];
+                edgeList.push_back(Edge<Coord>(pin[i], q, getDistance(_pinList[pin[i]], _pinList[q])));
+            }
+        }
+        radixSort(edgeList, [](const Edge<Coord>& edge) {
+            return (UCoord)edge._cost;
+        }, threadNum);
+        par.resize(_pinNum);
+        iota(par.begin(), par.end(), 0);
+        auto findRoot = [&](size_t x) {
+            while (par[x] != x) {
+                par[x] = par[par[x]];
+                x = par[x];
+            }
+            return x;
+        };
+        _treeList.clear();
+        for (size_t i = 0, end = edgeList.size(); i < end; ++i) {
+            size_t x = findRoot(edgeList[i]._s);
+            size_t y = findRoot(edgeList[i]._t);
+            if (x != y) {
+                par[x] = y;
+                _treeList.push_back(edgeList[i]);
+            }
+        }
+        edgeList.clear();
+    }
+
+    // Steiner points
+    vector<uint8_t> dirty(_pinNum, 1);
+    this->refineSteinerTree(dirty);
+    return true;
+}
+
+// Route the pins of member as a net of their own and add its tree: the
+// Steiner tree by routeFlat(), or only the spanning tree. Steiner pins are
+// appended to the pin list.
+template <class Coord>
+void Router<Coord>::routeSubnet(const vector<Index>& member, bool steiner)
+{
+    size_t num = member.size();
+    Router<Coord> router;
+    router._option = _option;
+    router._option._tileSize = 0;
+    router._option._multilevel = false;
+    for (size_t j = 0; j < num; ++j) {
+        router._pinList.push_back(_pinList[member[j]]);
+    }
+    router._pinNum = router._oPinNum = router._uPinNum = num;
+    if (steiner) {
+        router.routeFlat();
+    }
+    else if (!router.routeSmall()) {
+        router.genSpanningGraph();
+        router.genSpanningTree();
+    }
+
+    vector<Index> globalId(router._pinNum);
+    copy(member.begin(), member.end(), globalId.begin());
+    for (size_t j = num; j < router._pinNum; ++j) {
+        globalId[j] = _pinNum++;
+        _pinList.push_back(router._pinList[j]);
+    }
+    for (size_t j = 0, end = router._treeList.size(); j < end; ++j) {
+        const Edge<Coord>& edge = router._treeList[j];
+        _treeList.push_back(Edge<Coord>(globalId[edge._s], globalId[edge._t], edge._cost));
+    }
+    return;
+}
+
+// Partitioned mode. The bounding box of the pins is cut into square tiles
+// of _tileSize, and each tile is routed by routeFlat() as a net of its own,
+// the tiles spread over the threads. The tile trees are then stitched by
+// Kruskal over their own edges together with the spanning graph edges
+// across tiles among the boundary pins (the pins within a band along the
+// tile sides, and the extreme pins of every tile), so a stitching edge may
+// also replace a longer edge inside a tile. A substitution round around the
+// stitching edges repairs the seams. Returns false, leaving the net to the
+// flat run, if the pins fall in a single tile.
+template <class Coord>
+bool Router<Coord>::routeTiled()
+{
+    typedef typename make_unsigned<Coord>::type UCoord;
+    size_t threadNum = getThreadNum(_option._threadNum);
+    size_t pinNum = _pinNum;
+    if (pinNum < 4) return false;
+
+    long minX = _pinList[0]._x, maxX = minX;
+    long minY = _pinList[0]._y, maxY = minY;
+    for (size_t i = 1; i < pinNum; ++i) {
+        minX = min(minX, (long)_pinList[i]._x);
+        maxX = max(maxX, (long)_pinList[i]._x);
+        minY = min(minY, (long)_pinList[i]._y);
+        maxY = max(maxY, (long)_pinList[i]._y);
+    }
+    // tiles far smaller than the pin spacing are doubled, so that the tile
+    // grid never outgrows the pins
+    long size = _option._tileSize;
+    while ((double)((maxX - minX) / size + 1) * ((maxY - minY) / size + 1) > pinNum) {
+        size *= 2;
+    }
+    size_t colNum = (maxX - minX) / size + 1;
+    size_t rowNum = (maxY - minY) / size + 1;
+    if (colNum * rowNum == 1) return false;
+
+    // pins bucketed by tile, empty tiles dropped
+    vector<Index> pinTile(pinNum);
+    vector<Index> start(colNum * rowNum + 1, 0);
+    for (size_t i = 0; i < pinNum; ++i) {
+        size_t col = (_pinList[i]._x - minX) / size;
+        size_t row = (_pinList[i]._y - minY) / size;
+        pinTile[i] = row * colNum + col;
+        start[pinTile[i] + 1] += 1;
+    }
+    partial_sum(start.begin(), start.end(), start.begin());
+    vector<Index> tilePin(pinNum);
+    vector<Index> next(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < pinNum; ++i) {
+        tilePin[next[pinTile[i]]++] = i;
+    }
+    vector<Index> tileId;
+    for (size_t t = 0, end = colNum * rowNum; t < end; ++t) {
+        if (start[t + 1] > start[t]) tileId.push_back(t);
+    }
+    _tileNum = tileId.size();
+
+    // route the tiles
+    vector<Router<Coord> > tile(_tileNum);
+    workStealingRun(_tileNum, threadNum, [&](size_t k) {
+        Router<Coord>& router = tile[k];
+        size_t t = tileId[k];
+        router._option = _option;
+        router._option._threadNum = 1;
+        for (size_t j = start[t]; j < start[t + 1]; ++j) {
+            router._pinList.push_back(_pinList[tilePin[j]]);
+        }
+        router._pinNum = router._oPinNum = router._uPinNum = router._pinList.size();
+        router.routeFlat();
+    });
+
+    // gather the tile trees, with the Steiner pins of each tile appended
+    _treeList.clear();
+    vector<Index> globalId;
+    for (size_t k = 0; k < _tileNum; ++k) {
+        Router<Coord>& router = tile[k];
+        size_t t = tileId[k];
+        globalId.resize(router._pinNum);
+        for (size_t j = 0; j < router._uPinNum; ++j) {
+            globalId[j] = tilePin[start[t] + j];
+        }
+        for (size_t j = router._uPinNum; j < router._pinNum; ++j) {
+            globalId[j] = _pinNum++;
+            _pinList.push_back(router._pinList[j]);
+        }
+        for (size_t j = 0, end = router._treeList.size(); j < end; ++j) {
+            const Edge<Coord>& edge = router._treeList[j];
+            _treeList.push_back(Edge<Coord>(globalId[edge._s], globalId[edge._t], edge._cost));
+        }
+        vector<Pin<Coord> >().swap(router._pinList);
+        vector<Edge<Coord> >().swap(router._edgeList);
+        vector<Edge<Coord> >().swap(router._treeList);
+    }
+
+    // boundary pins: within a band along the sides, or extreme in the tile
+    long band = max(size / 8, 1L);
+    vector<uint8_t> boundary(pinNum, 0);
+    for (size_t k = 0; k < _tileNum; ++k) {
+        size_t t = tileId[k];
+        long x0 = minX + (long)(t % colNum) * size;
+        long y0 = minY + (long)(t / colNum) * size;
+        size_t lo[2] = { tilePin[start[t]], tilePin[start[t]] };
+        size_t hi[2] = { tilePin[start[t]], tilePin[start[t]] };
+        for (size_t j = start[t]; j < start[t + 1]; ++j) {
+            size_t i = tilePin[j];
+            long x = _pinList[i]._x, y = _pinList[i]._y;
+            if (x - x0 < band || x0 + size - 1 - x < band ||
+                y - y0 < band || y0 + size - 1 - y < band) {
+                boundary[i] = 1;
+            }
+            if (x < _pinList[lo[0]]._x) lo[0] = i;
+            if (x > _pinList[hi[0]]._x) hi[0] = i;
+            if (y < _pinList[lo[1]]._y) lo[1] = i;
+            if (y > _pinList[hi[1]]._y) hi[1] = i;
+        }
+        boundary[lo[0]] = boundary[hi[0]] = boundary[lo[1]] = boundary[hi[1]] = 1;
+    }
+    vector<Pin<Coord> > boundaryPin;
+    vector<Index> boundaryId;
+    for (size_t i = 0; i < pinNum; ++i) {
+        if (boundary[i]) {
+            boundaryPin.push_back(_pinList[i]);
+            boundaryId.push_back(i);
+        }
+    }
+
+    // Kruskal over the tile trees and the boundary graph edges across tiles
+    vector<Edge<Coord> > edgeList;
+    _fenwick.genEdges(boundaryPin, edgeList);
+    size_t treeNum = _treeList.size();
+    for (size_t i = 0, end = edgeList.size(); i < end; ++i) {
+        size_t s = boundaryId[edgeList[i]._s];
+        size_t t = boundaryId[edgeList[i]._t];
+        if (pinTile[s] != pinTile[t]) {
+            _treeList.push_back(Edge<Coord>(s, t, edgeList[i]._cost));
+        }
+    }
+    vector<Index> order(_treeList.size());
+    iota(order.begin(), order.end(), 0);
+    radixSort(order, [&](Index i) {
+        return (UCoord)_treeList[i]._cost;
+    }, threadNum);
+    vector<Index> par(_pinNum);
+    iota(par.begin(), par.end(), 0);
+    auto findRoot = [&](size_t x) {
+        while (par[x] != x) {
+            par[x] = par[par[x]];
+            x = par[x];
+        }
+        return x;
+    };
+    vector<uint8_t> dirty(_pinNum, 0);
+    edgeList.clear();
+    for (size_t i = 0, end = order.size(); i < end; ++i) {
+        const Edge<Coord>& edge = _treeList[order[i]];
+        size_t x = findRoot(edge._s);
+        size_t y = findRoot(edge._t);
+        if (x != y) {
+            par[x] = y;
+            edgeList.push_back(edge);
+            if (order[i] >= treeNum) {
+                dirty[edge._s] = dirty[edge._t] = 1;
+            }
+        }
+    }
+    assert(edgeList.size() + 1 == _pinNum);
+    _treeList.swap(edgeList);
+
+    // repair the seams
+    this->refineSteinerTree(dirty);
+    return true;
+}
+
+// Incremental routing. The Steiner tree of route() is kept in _eco. Pin
+// changes only edit it: a new pin is hooked to the nearest point of the
+// tree, a removed pin leaves a Steiner point behind. repair() then routes
+// again the region around the touched points, so its time follows the
+// size of the changes.
+template <class Coord>
+void Router<Coord>::addPin(const string& name, long x, long y)
+{
+    assert(_option._incremental);
+    assert(_xmin <= x && x <= _xmax && _ymin <= y && y <= _ymax);
+    Pin<Coord> pin(x, y);
+    Index p = _eco.findNearest(pin);
+    if (p == EcoTree<Coord>::NONE || _eco.getPin(p)._x != pin._x || _eco.getPin(p)._y != pin._y) {
+        Index q = _eco.addPoint(pin);
+        if (p != EcoTree<Coord>::NONE) {
+            _eco.addEdge(q, p);
+        }
+        p = q;
+    }
+    bool ok = _eco.addName(name, p);
+    assert(ok);
+    (void)ok;
+    _ecoSeed.push_back(p);
+    ++_changeNum;
+    ++_totalChangeNum;
+    return;
+}
+
+template <class Coord>
+void Router<Coord>::removePin(const string& name)
+{
+    assert(_option._incremental);
+    Index p = _eco.removeName(name);
+    assert(p != EcoTree<Coord>::NONE);
+    _ecoSeed.push_back(p);
+    ++_changeNum;
+    ++_totalChangeNum;
+    return;
+}
+
+template <class Coord>
+void Router<Coord>::movePin(const string& name, long x, long y)
+{
+    this->removePin(name);
+    this->addPin(name, x, y);
+    --_changeNum;
+    --_totalChangeNum;
+    return;
+}
+
+// Route again the points within ECO_HOP_NUM tree edges of the changes, or
+// the whole net once the changes since the last full route reach
+// _rerouteRatio of the pins; the local repairs drift from the tree a full
+// route would give. The result is left as it is, see genResult().
+template <class Coord>
+void Router<Coord>::repair()
+{
+    static const size_t ECO_HOP_NUM = 2;
+    assert(_option._incremental);
+    if (_ecoSeed.empty()) return;
+
+    clock_t start = clock();
+    if (_changeNum > _option._rerouteRatio * _eco.getNameNum()) {
+        this->rerouteEco();
+    }
+    else {
+        vector<vector<Index> > piece;
+        _eco.getRegion(_ecoSeed, ECO_HOP_NUM, piece);
+        for (size_t i = 0, end = piece.size(); i < end; ++i) {
+            this->repairRegion(piece[i]);
+        }
+    }
+    _ecoSeed.clear();
+    _repairTime += clock() - start;
+    return;
+}
+
+// Cut the edges of one region and span its remaining points by a Steiner
+// tree of their own. Each of them holds a different part of the rest of
+// the tree, so the result is a tree again.
+template <class Coord>
+void Router<Coord>::repairRegion(const vector<Index>& piece)
+{
+    vector<Index> keep;
+    _eco.cutRegion(piece, keep);
+
+    // points at the same place are joined and routed once
+    sort(keep.begin(), keep.end(), [&](Index a, Index b) {
+        const Pin<Coord>& p = _eco.getPin(a);
+        const Pin<Coord>& q = _eco.getPin(b);
+        return (p._x < q._x || (p._x == q._x && p._y < q._y));
+    });
+    vector<Index> member;
+    for (size_t i = 0, end = keep.size(); i < end; ++i) {
+        const Pin<Coord>& pin = _eco.getPin(keep[i]);
+        if (!member.empty() && _eco.getPin(member.back())._x == pin._x &&
+            _eco.getPin(member.back())._y == pin._y) {
+            _eco.addEdge(member.back(), keep[i]);
+        }
+        else {
+            member.push_back(keep[i]);
+        }
+    }
+
+    size_t num = member.size();
+    Router<Coord> router;
+    router._option = _option;
+    router._option._tileSize = 0;
+    router._option._multilevel = false;
+    router._option._incremental = false;
+    for (size_t j = 0; j < num; ++j) {
+        router._pinList.push_back(_eco.getPin(member[j]));
+    }
+    router._pinNum = router._oPinNum = router._uPinNum = num;
+    router.routeFlat();
+
+    vector<Index> id(router._pinNum);
+    copy(member.begin(), member.end(), id.begin());
+    for (size_t j = num; j < router._pinNum; ++j) {
+        id[j] = _eco.addPoint(router._pinList[j]);
+        keep.push_back(id[j]);
+    }
+    for (size_t j = 0, end = router._treeList.size(); j < end; ++j) {
+        _eco.addEdge(id[router._treeList[j]._s], id[router._treeList[j]._t]);
+    }
+    _eco.prune(keep);
+    return;
+}
+
+// Full route of the current pins, keeping their names.
+template <class Coord>
+void Router<Coord>::rerouteEco()
+{
+    vector<Index> term;
+    _eco.getTerminals(_pinList, term);
+    _pinNum = _uPinNum = _pinList.size();
+    _edgeList.clear();
+    _treeList.clear();
+    _queryList.clear();
+    this->routeTree();
+    _eco.build(_pinList, _treeList, term);
+    this->releaseScratch();
+    _changeNum = 0;
+    ++_rerouteNum;
+    return;
+}
+
+// Rebuild the rectilinear result from the kept tree. It takes a pass over
+// the whole net, so it is left to the caller after a round of repairs.
+template <class Coord>
+void Router<Coord>::genResult()
+{
+    _uPinNum = _eco.getTree(_pinList, _pinName, _dupPin, _treeList);
+    _pinNum = _pinList.size();
+    _oPinNum = _eco.getNameNum();
     this->rectilinearize();
-    _stop = clock();
+    if (_option._compact) {
+        _compactor.compact(_pinList, _uPinNum, _treeList);
+        _pinNum = _pinList.size();
+    }
+    return;
+}
 
-    this->printSummary();
+// Change list: "ADD <name> (x,y)", "MOVE <name> (x,y)" and "REMOVE <name>"
+// edit the pins, "REPAIR" repairs the tree after the changes so far. At the
+// end the tree is repaired once more and the result is rebuilt. The buffer
+// may be released after.
+template <class Coord>
+void Router<Coord>::applyChange(const char* begin, const char* end)
+{
+    Scanner scanner(begin, end);
+    while (!scanner.eof()) {
+        long x, y;
+        if (scanner.match("ADD")) {
+            string name = scanner.getToken().str();
+            scanner.getPoint(x, y);
+            this->addPin(name, x, y);
+        }
+        else if (scanner.match("MOVE")) {
+            string name = scanner.getToken().str();
+            scanner.getPoint(x, y);
+            this->movePin(name, x, y);
+        }
+        else if (scanner.match("REMOVE")) {
+            this->removePin(scanner.getToken().str());
+        }
+        else {
+            bool ok = scanner.match("REPAIR");
+            assert(ok);
+            (void)ok;
+            this->repair();
+        }
+    }
+    this->repair();
+    this->genResult();
     return;
 }
 
 // reporting functions
-void Router::reportPin() const
+template <class Coord>
+void Router<Coord>::reportPin() const
 {
     cout << "Number of pins: " << _pinNum << endl;
     assert(_pinNum == _pinList.size());
     for (size_t i = 0; i < _pinNum; ++i) {
-        cout << left << setw(6) << _pinList[i]._name << " ("
+        string name = (i < _uPinNum)? _pinName[i].str(): "";
+        cout << left << setw(6) << name << " ("
              << _pinList[i]._x << "," << _pinList[i]._y << ")" << endl;
     }
+    for (size_t i = 0, end = _dupPin.size(); i < end; ++i) {
+        const Pin<Coord>& pin = _pinList[_dupPin[i]];
+        cout << left << setw(6) << _pinName[_uPinNum + i].str() << " ("
+             << pin._x << "," << pin._y << ")" << endl;
+    }
     return;
 }
 
-void Router::reportEdge() const
+template <class Coord>
+void Router<Coord>::reportEdge() const
 {
     cout << "Number of edges: " << _treeList.size() << endl;
     for (size_t i = 0, end = _treeList.size(); i < end; ++i) {
@@ -360,43 +1651,83 @@ void Router::reportEdge() const
     return;
 }
 
-void Router::printSummary() const
+template <class Coord>
+void Router<Coord>::printSummary() const
 {
     cout << "=======================================================" << endl;
     cout << "NumRoutedPins = " << _oPinNum << endl;
     cout << "WireLength = " << this->getCost(_treeList) << endl;
+    if (_tileNum > 0) {
+        cout << "NumTiles = " << _tileNum << endl;
+    }
+    if (_levelNum > 0) {
+        cout << "NumLevels = " << _levelNum << endl;
+    }
+    if (_flatCost >= 0) {
+        long cost = this->getCost(_treeList);
+        cout << "FlatWireLength = " << _flatCost << " (penalty "
+             << 100.0 * (cost - _flatCost) / max(_flatCost, 1L) << "%)" << endl;
+    }
     cout << "Time = " << (double)(_stop - _start) / CLOCKS_PER_SEC << " secs " << endl;
+    cout << "ScratchMemory = " << _scratchSize << " bytes" << endl;
+    if (_totalChangeNum > 0) {
+        cout << "NumChanges = " << _totalChangeNum << endl;
+        cout << "NumReroutes = " << _rerouteNum << endl;
+        cout << "RepairTime = " << (double)_repairTime / CLOCKS_PER_SEC << " secs " << endl;
+    }
     cout << "=======================================================" << endl;
     return;
 }
 
-void Router::writeResult(fstream& outFile)
+template <class Coord>
+void Router<Coord>::writeResult(Writer& writer)
 {
-    outFile << "NumRoutedPins = " << _oPinNum << endl;
-    outFile << "WireLength = " << this->getCost(_treeList) << endl;
+    writer.put("NumRoutedPins = ");
+    writer.putInt(_oPinNum);
+    writer.put("\nWireLength = ");
+    writer.putInt(this->getCost(_treeList));
+    writer.put('\n');
 
     for (size_t i = 0, end = _treeList.size(); i < end; ++i) {
-        const Pin& s = _pinList[_treeList[i]._s];
-        const Pin& t = _pinList[_treeList[i]._t];
+        const Pin<Coord>& s = _pinList[_treeList[i]._s];
+        const Pin<Coord>& t = _pinList[_treeList[i]._t];
         assert(s._x == t._x || s._y == t._y);
-        if (s._y == t._y) {
-            outFile << "H-line (" << s._x << "," << s._y << ") (" << t._x << "," << t._y << ")" << endl;
-        }
-        else {
-            outFile << "V-line (" << s._x << "," << s._y << ") (" << t._x << "," << t._y << ")" << endl;
-        }
+        writer.put((s._y == t._y)? "H-line (": "V-line (", 8);
+        writer.putInt(s._x);
+        writer.put(',');
+        writer.putInt(s._y);
+        writer.put(") (", 3);
+        writer.putInt(t._x);
+        writer.put(',');
+        writer.putInt(t._y);
+        writer.put(")\n", 2);
     }
 
     return;
 }
 
-long Router::getCost(const vector<Edge>& treeList) const
+// Copy the routed wires to wire, at most capacity of them. Returns the
+// number of wires of the net, so that a short buffer can be grown.
+template <class Coord>
+size_t Router<Coord>::getWires(Wire* wire, size_t capacity) const
+{
+    size_t wireNum = _treeList.size();
+    for (size_t i = 0, end = min(wireNum, capacity); i < end; ++i) {
+        const Pin<Coord>& s = _pinList[_treeList[i]._s];
+        const Pin<Coord>& t = _pinList[_treeList[i]._t];
+        wire[i] = Wire(s._x, s._y, t._x, t._y);
+    }
+    return wireNum;
+}
+
+template <class Coord>
+long Router<Coord>::getCost(const vector<Edge<Coord> >& treeList) const
 {
     long cost = 0;
 
     for (size_t i = 0, end = treeList.size(); i < end; ++i) {
-        const Pin& s = _pinList[treeList[i]._s];
-        const Pin& t = _pinList[treeList[i]._t];
+        const Pin<Coord>& s = _pinList[treeList[i]._s];
+        const Pin<Coord>& t = _pinList[treeList[i]._t];
         cost += getDistance(s, t);
     }
 
@@ -404,7 +1735,8 @@ long Router::getCost(const vector<Edge>& treeList) const
 }
 
 // opencv depended
-void Router::drawResult(string name) const
+template <class Coord>
+void Router<Coord>::drawResult(string name) const
 {
     // scaling factor
     double sf = 1;
@@ -418,7 +1750,7 @@ void Router::drawResult(string name) const
     for (size_t i = 0, end = _pinList.size(); i < end; ++i) {
         size_t x = round(_pinList[i]._x*sf);
         size_t y = imgY - round(_pinList[i]._y*sf);
-        if (i < _oPinNum)
+        if (i < _uPinNum)
             circle(image, Point(x, y), 5, Scalar(0, 128, 0), CV_FILLED);
         else
             circle(image, Point(x, y), 5, Scalar(0, 0, 128), CV_FILLED);
@@ -436,3 +1768,47 @@ void Router::drawResult(string name) const
 
     return;
 }
+
+// coordinate width selection
+size_t getCoordWidth(const char* begin, const char* end)
+{
+    Scanner scanner(begin, end);
+    long xmin, ymin, xmax, ymax;
+    bool ok = scanner.match("Boundary") && scanner.match("=");
+    scanner.getPoint(xmin, ymin);
+    ok = ok && scanner.match(",");
+    scanner.getPoint(xmax, ymax);
+    assert(ok);
+    (void)ok;
+    return getCoordWidth(xmin, ymin, xmax, ymax);
+}
+
+size_t getCoordWidth(long xmin, long ymin, long xmax, long ymax)
+{
+    long absX = max(labs(xmin), labs(xmax));
+    long absY = max(labs(ymin), labs(ymax));
+    long need = max(absX + absY, (xmax - xmin) + (ymax - ymin));
+    if (need < numeric_limits<int16_t>::max()) return 16;
+    if (need < numeric_limits<int32_t>::max()) return 32;
+    return 64;
+}
+
+RouterBase* createRouter(size_t width)
+{
+    switch (width) {
+        case 16:
+            return new Router<int16_t>();
+        case 32:
+            return new Router<int32_t>();
+        case 64:
+            return new Router<int64_t>();
+        default:
+            assert(0);
+            break;
+    }
+    return 0;
+}
+
+template class Router<int16_t>;
+template class Router<int32_t>;
+template class Router<int64_t>;
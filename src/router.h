@@ -8,58 +8,197 @@
 #define ROUTER_H
 
 #include <vector>
-#include <fstream>
+#include <iostream>
 #include "module.h"
 #include "mergeTree.h"
+#include "writer.h"
+#include "spanningGraph.h"
+#include "compact.h"
+#include "eco.h"
+#include "arena.h"
 using namespace std;
 
-class Router
+class RouterOption
+{
+public:
+    RouterOption() :
+        _fenwickSweep(false), _filterKruskal(false), _batchSteiner(false),
+        _steinerTol(0), _steinerPass(1), _passGain(1e-4), _compact(true),
+        _hilbertOrder(false), _tileSize(0), _multilevel(false),
+        _flatCompare(false), _incremental(false), _rerouteRatio(0.2),
+        _threadNum(1) {}
+    ~RouterOption() {}
+
+    // data members
+    bool        _fenwickSweep;  // spanning graph by fenwick tree sweep
+    bool        _filterKruskal; // spanning tree by parallel filter-kruskal
+    bool        _batchSteiner;  // steiner points inserted in parallel batches
+    double      _steinerTol;    // gain given up by batches, ratio of mst cost
+    size_t      _steinerPass;   // max rounds of edge substitution
+    double      _passGain;      // stop when a round gains less, ratio of cost
+    bool        _compact;       // merge overlapping wires after rectilinearize
+    bool        _hilbertOrder;  // renumber pins along a hilbert curve
+    long        _tileSize;      // tile side of the partitioned mode, 0 for flat
+    bool        _multilevel;    // route coarsened pins, then refine level by level
+    bool        _flatCompare;   // also route flat and report the penalty
+    bool        _incremental;   // keep the tree for pin changes, see EcoTree
+    double      _rerouteRatio;  // full reroute after this many changes per pin
+    size_t      _threadNum;     // threads per net, 0 for all cores
+};
+
+// Width-independent interface of the router. A net is routed by the
+// Router instantiation for its coordinate width, see createRouter().
+class RouterBase
 {
 public:
     // constructor and destructor
-    Router(fstream& inFile) {
-        this->parseInput(inFile);
+    RouterBase() {}
+    virtual ~RouterBase() {}
+
+    // basic access methods
+    const RouterOption& getOption() const   { return _option; }
+    void setOption(const RouterOption& option) { _option = option; }
+    virtual size_t getOPinNum() const = 0;
+    virtual long getWireLength() const = 0;
+    virtual size_t getWires(Wire* wire, size_t capacity) const = 0;
+
+    // modify methods
+    virtual void reset() = 0;
+    virtual void parseInput(const char* begin, const char* end) = 0;
+    virtual void setInput(const long* x, const long* y, size_t pinNum) = 0;
+    virtual void route() = 0;
+    virtual void addPin(const string& name, long x, long y) = 0;
+    virtual void removePin(const string& name) = 0;
+    virtual void movePin(const string& name, long x, long y) = 0;
+    virtual void repair() = 0;
+    virtual void genResult() = 0;
+    virtual void applyChange(const char* begin, const char* end) = 0;
+
+    // reporting functions
+    virtual void reportPin() const = 0;
+    virtual void reportEdge() const = 0;
+    virtual void printSummary() const = 0;
+    virtual void writeResult(Writer& writer) = 0;
+
+    // opencv-depended
+    virtual void drawResult(string name) const = 0;
+
+protected:
+    RouterOption    _option;        // routing options
+};
+
+template <class Coord>
+class Router : public RouterBase
+{
+public:
+    // constructor and destructor
+    Router() : _scratchSize(0) {}
+    Router(const char* begin, const char* end) : _scratchSize(0) {
+        this->parseInput(begin, end);
     }
     ~Router()   { }
 
     // basic access methods
-    int getXmin() const { return _xmin; }
-    int getYmin() const { return _ymin; }
-    int getXmax() const { return _xmax; }
-    int getYmax() const { return _ymax; }
-    int getPinNum() const   { return _pinNum; }
+    Coord getXmin() const   { return _xmin; }
+    Coord getYmin() const   { return _ymin; }
+    Coord getXmax() const   { return _xmax; }
+    Coord getYmax() const   { return _ymax; }
+    size_t getPinNum() const    { return _pinNum; }
+    size_t getOPinNum() const   { return _oPinNum; }
+    long getWireLength() const  { return getCost(_treeList); }
+    size_t getScratchSize() const   { return _scratchSize; }
+    const Arena& getArena() const   { return _arena; }
+    size_t getWires(Wire* wire, size_t capacity) const;
 
     // modify methods
-    void parseInput(fstream& inFile);
+    void reset();
+    void parseInput(const char* begin, const char* end);
+    void setInput(const long* x, const long* y, size_t pinNum);
     void genSpanningGraph();
     void genSpanningTree();
     void genSteinerTree();
+    void refineSteinerTree(const vector<uint8_t>& dirty);
     void rectilinearize();
     void route();
 
+    // incremental routing, after route() with _incremental set
+    void addPin(const string& name, long x, long y);
+    void removePin(const string& name);
+    void movePin(const string& name, long x, long y);
+    void repair();
+    void genResult();
+    void applyChange(const char* begin, const char* end);
+
     // reporting functions
     void reportPin() const;
     void reportEdge() const;
     void printSummary() const;
-    void writeResult(fstream& outFile);
-    long getCost(const vector<Edge>& treeList) const;
+    void writeResult(Writer& writer);
+    long getCost(const vector<Edge<Coord> >& treeList) const;
 
     // opencv-depended
     void drawResult(string name) const;
 
 private:
-    int             _xmin;          // chip boundary
-    int             _ymin;          // chip boundary
-    int             _xmax;          // chip boundary
-    int             _ymax;          // chip boundary
+    FenwickSweep<Coord> _fenwick;   // fenwick tree spanning graph engine
+    SegmentCompactor<Coord> _compactor; // segment compaction post-pass
+    EcoTree<Coord>  _eco;           // steiner tree kept for pin changes
+    Arena           _arena;         // scratch memory of the net
+    Arena           _sweepArena[4]; // scratch of the four sweep regions
+    size_t          _scratchSize;   // scratch bytes taken by the last net
+    Coord           _xmin;          // chip boundary
+    Coord           _ymin;          // chip boundary
+    Coord           _xmax;          // chip boundary
+    Coord           _ymax;          // chip boundary
     size_t          _pinNum;        // number of pins (original + steiner)
     size_t          _oPinNum;       // number of original pins
+    size_t          _uPinNum;       // number of distinct original pins
+    size_t          _tileNum;       // number of tiles routed, 0 if flat
+    size_t          _levelNum;      // number of levels routed, 0 if flat
+    long            _flatCost;      // wirelength of the flat run, or -1
+    size_t          _changeNum;     // pin changes since the last full route
+    size_t          _totalChangeNum;    // pin changes since route()
+    size_t          _rerouteNum;    // full reroutes forced by the changes
+    clock_t         _repairTime;    // time spent in the local repairs
     clock_t         _start;         // starting time
     clock_t         _stop;          // stopping time
-    vector<Pin>     _pinList;       // list of pins
-    vector<Edge>    _edgeList;      // list of edges
-    vector<Edge>    _treeList;      // list of edges on tree
-    vector<Query>   _queryList;     // list of querys
+    vector<Pin<Coord> >     _pinList;   // list of pins
+    vector<StrView>         _pinName;   // names of the original pins
+    vector<Index>           _dupPin;    // pin of each duplicate, see dedupPins()
+    vector<Edge<Coord> >    _edgeList;  // list of edges
+    vector<Edge<Coord> >    _treeList;  // list of edges on tree
+    vector<Index>           _treeId;    // _edgeList index of each tree edge
+    vector<Query<Coord> >   _queryList; // list of querys
+    vector<Index>           _ecoSeed;   // points touched since the last repair
+
+    // private member functions
+    void dedupPins();
+    void reorderPins();
+    bool routeSmall();
+    void routeTree();
+    void routeFlat();
+    bool routeTiled();
+    bool routeMultilevel();
+    void routeSubnet(const vector<Index>& member, bool steiner);
+    void repairRegion(const vector<Index>& piece);
+    void rerouteEco();
+    void releaseScratch();
+    void getChangedPins(size_t firstPin, vector<uint8_t>& dirty) const;
+    void getAdjacency(const vector<Edge<Coord> >& edgeList, ArenaVector<size_t>& adjStart,
+                      ArenaVector<Index>& adjPin);
+    void sweepMultimap();
+    void untangleCorners(vector<uint8_t>& corner) const;
+    void insertSteinerBatch(vector<uint8_t>& alive, vector<Edge<Coord> >& treeList);
+    void addSteinerPin(const Query<Coord>& query, size_t pinId, Edge<Coord>* edge);
 };
 
+// Coordinate width (16, 32 or 64) needed by the net in [begin, end): the
+// narrowest signed type that holds |x| + |y| of every boundary corner and
+// the Manhattan distance across the boundary.
+size_t getCoordWidth(const char* begin, const char* end);
+size_t getCoordWidth(long xmin, long ymin, long xmax, long ymax);
+
+// router for the given coordinate width
+RouterBase* createRouter(size_t width);
+
 #endif // ROUTER_H
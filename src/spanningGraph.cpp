@@ -0,0 +1,109 @@
+/****************************************************************************
+  FileName  [ spanningGraph.cpp ]
+  Synopsis  [ Implementation of the Fenwick-tree octant sweep. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.22 ]
+****************************************************************************/
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+#include "spanningGraph.h"
+using namespace std;
+
+template <class Coord>
+void FenwickSweep<Coord>::genEdges(const vector<Pin<Coord> >& pinList, vector<Edge<Coord> >& edgeList)
+{
+    size_t pinNum = pinList.size();
+    size_t first = edgeList.size();
+    _x.resize(pinNum);
+    _y.resize(pinNum);
+    for (size_t i = 0; i < pinNum; ++i) {
+        _x[i] = pinList[i]._x;
+        _y[i] = pinList[i]._y;
+    }
+
+    // four transforms cover the eight octants
+    for (size_t dir = 0; dir < 4; ++dir) {
+        if (dir == 1 || dir == 3) {
+            _x.swap(_y);
+        }
+        else if (dir == 2) {
+            for (size_t i = 0; i < pinNum; ++i) _x[i] = -_x[i];
+        }
+        this->sweep(pinList, edgeList);
+    }
+
+    // a pair found from both of its ends, or in two transforms, is kept once
+    sort(edgeList.begin() + first, edgeList.end(), [](const Edge<Coord>& e1, const Edge<Coord>& e2) {
+         return (e1._s < e2._s || (e1._s == e2._s && e1._t < e2._t));
+    });
+    edgeList.erase(unique(edgeList.begin() + first, edgeList.end(), [](const Edge<Coord>& e1, const Edge<Coord>& e2) {
+         return (e1._s == e2._s && e1._t == e2._t);
+    }), edgeList.end());
+    return;
+}
+
+// For each pin p, find the pin q with q.x >= p.x and q.y - q.x >= p.y - p.x
+// that minimizes q.x + q.y, i.e. the nearest pin in that octant.
+template <class Coord>
+void FenwickSweep<Coord>::sweep(const vector<Pin<Coord> >& pinList, vector<Edge<Coord> >& edgeList)
+{
+    size_t pinNum = pinList.size();
+    const Coord inf = numeric_limits<Coord>::max();
+
+    _ids.resize(pinNum);
+    for (size_t i = 0; i < pinNum; ++i) _ids[i] = i;
+    sort(_ids.begin(), _ids.end(), [&](size_t id1, size_t id2) {
+         return (_x[id1] < _x[id2] || (_x[id1] == _x[id2] && _y[id1] < _y[id2]));
+    });
+
+    // rank-compress y - x; ranks are reversed so that a suffix query
+    // becomes a prefix query on the fenwick tree
+    _keys.resize(pinNum);
+    for (size_t i = 0; i < pinNum; ++i) _keys[i] = _y[i] - _x[i];
+    sort(_keys.begin(), _keys.end());
+    _keys.erase(unique(_keys.begin(), _keys.end()), _keys.end());
+    size_t keyNum = _keys.size();
+    _rank.resize(pinNum);
+    for (size_t i = 0; i < pinNum; ++i) {
+        size_t pos = lower_bound(_keys.begin(), _keys.end(), _y[i] - _x[i]) - _keys.begin();
+        _rank[i] = keyNum - pos;
+    }
+
+    _minVal.assign(keyNum + 1, inf);
+    _minId.assign(keyNum + 1, 0);
+
+    for (size_t i = pinNum; i-- > 0;) {
+        size_t id = _ids[i];
+        Coord val = _x[id] + _y[id];
+
+        // query prefix [1, rank]
+        Coord best = inf;
+        size_t bestId = 0;
+        for (size_t r = _rank[id]; r > 0; r -= r & (0 - r)) {
+            if (_minVal[r] < best) {
+                best = _minVal[r];
+                bestId = _minId[r];
+            }
+        }
+        if (best != inf) {
+            const Pin<Coord>& p1 = pinList[bestId];
+            const Pin<Coord>& p2 = pinList[id];
+            edgeList.push_back(Edge<Coord>(min(bestId, id), max(bestId, id), abs(p1._x - p2._x) + abs(p1._y - p2._y)));
+        }
+
+        // update
+        for (size_t r = _rank[id]; r <= keyNum; r += r & (0 - r)) {
+            if (val < _minVal[r]) {
+                _minVal[r] = val;
+                _minId[r] = id;
+            }
+        }
+    }
+    return;
+}
+
+// coordinate widths picked by getCoordWidth()
+template class FenwickSweep<int16_t>;
+template class FenwickSweep<int32_t>;
+template class FenwickSweep<int64_t>;
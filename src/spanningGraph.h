@@ -0,0 +1,43 @@
+/****************************************************************************
+  FileName  [ spanningGraph.h ]
+  Synopsis  [ Define the Fenwick-tree octant sweep for the spanning graph. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.22 ]
+****************************************************************************/
+#ifndef SPANNINGGRAPH_H
+#define SPANNINGGRAPH_H
+
+#include <vector>
+#include "module.h"
+using namespace std;
+
+// Rectilinear spanning graph by the octant construction: for every pin and
+// every octant, the nearest pin in that octant is found with a Fenwick tree
+// (prefix minimum) over rank-compressed (y - x). At most 4n edges are
+// produced, each pin pair once with _s < _t. All scratch arrays are kept
+// between calls.
+template <class Coord>
+class FenwickSweep
+{
+public:
+    // constructor and destructor
+    FenwickSweep() {}
+    ~FenwickSweep() {}
+
+    // modify methods
+    void genEdges(const vector<Pin<Coord> >& pinList, vector<Edge<Coord> >& edgeList);
+
+private:
+    vector<Index>   _ids;       // pins in sweep order
+    vector<Coord>   _x;         // transformed x-coordinate
+    vector<Coord>   _y;         // transformed y-coordinate
+    vector<Coord>   _keys;      // sorted distinct y - x
+    vector<Index>   _rank;      // rank of y - x of each pin
+    vector<Coord>   _minVal;    // fenwick tree: min x + y
+    vector<Index>   _minId;     // fenwick tree: pin attaining the min
+
+    // private member functions
+    void sweep(const vector<Pin<Coord> >& pinList, vector<Edge<Coord> >& edgeList);
+};
+
+#endif // SPANNINGGRAPH_H
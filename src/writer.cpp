@@ -0,0 +1,72 @@
+/****************************************************************************
+  FileName  [ writer.cpp ]
+  Synopsis  [ Implementation of the buffered result writer. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.21 ]
+****************************************************************************/
+#include "writer.h"
+using namespace std;
+
+static const char digitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// count decimal digits of v
+static inline size_t digitNum(unsigned long v)
+{
+    size_t n = 1;
+    for (;;) {
+        if (v < 10) return n;
+        if (v < 100) return n + 1;
+        if (v < 1000) return n + 2;
+        if (v < 10000) return n + 3;
+        v /= 10000;
+        n += 4;
+    }
+}
+
+// two digits per step from the back, length known up front
+void Writer::putInt(long val)
+{
+    this->reserve(21);
+    char* p = &_buf[_size];
+    unsigned long v = val;
+    if (val < 0) {
+        *p++ = '-';
+        v = 0 - v;
+    }
+    size_t len = digitNum(v);
+    char* q = p + len;
+    while (v >= 100) {
+        size_t i = (v % 100) * 2;
+        v /= 100;
+        *--q = digitPairs[i + 1];
+        *--q = digitPairs[i];
+    }
+    if (v >= 10) {
+        *--q = digitPairs[v * 2 + 1];
+        *--q = digitPairs[v * 2];
+    }
+    else {
+        *--q = (char)('0' + v);
+    }
+    _size = (p + len) - &_buf[0];
+    return;
+}
+
+void Writer::flush()
+{
+    if (_sink && _size > 0) {
+        _sink->write(&_buf[0], _size);
+        _size = 0;
+    }
+    return;
+}
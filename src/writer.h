@@ -0,0 +1,67 @@
+/****************************************************************************
+  FileName  [ writer.h ]
+  Synopsis  [ Define the buffered result writer. ]
+  Author    [ Fu-Yu Chuang ]
+  Date      [ 2017.6.21 ]
+****************************************************************************/
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <vector>
+#include <cstring>
+#include <iostream>
+using namespace std;
+
+// Formats into one reusable buffer and hands it to the sink in large
+// blocks. Without a sink everything is kept until clear().
+class Writer
+{
+public:
+    // constructor and destructor
+    Writer(size_t blockSize = 1 << 20) :
+        _sink(0), _blockSize(blockSize), _size(0) {
+        _buf.resize(_blockSize + 64);
+    }
+    Writer(ostream& sink, size_t blockSize = 1 << 20) :
+        _sink(&sink), _blockSize(blockSize), _size(0) {
+        _buf.resize(_blockSize + 64);
+    }
+    ~Writer() { this->flush(); }
+
+    // basic access methods
+    const char* data() const    { return &_buf[0]; }
+    size_t size() const         { return _size; }
+
+    // modify methods
+    void put(char c) {
+        this->reserve(1);
+        _buf[_size++] = c;
+    }
+    void put(const char* str, size_t len) {
+        this->reserve(len);
+        memcpy(&_buf[_size], str, len);
+        _size += len;
+    }
+    void put(const char* str) { this->put(str, strlen(str)); }
+    void putInt(long val);
+    void flush();
+    void clear() { _size = 0; }
+
+private:
+    ostream*        _sink;          // destination, null to keep in memory
+    size_t          _blockSize;     // flush threshold
+    size_t          _size;          // bytes in use
+    vector<char>    _buf;           // format buffer
+
+    // make room for len more bytes
+    void reserve(size_t len) {
+        if (_size + len <= _buf.size()) return;
+        if (_sink) {
+            this->flush();
+            if (len <= _buf.size()) return;
+        }
+        _buf.resize(max(_buf.size() * 2, _size + len));
+    }
+};
+
+#endif // WRITER_H